@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "AssetPack.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char PACK_MAGIC[4] = { 'A', 'P', 'K', '1' };
+static const uint32_t PACK_VERSION = 1;
+static const uint64_t PACK_ALIGNMENT = 4096;
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+bool AssetPack::open(const char* path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_MAP " << path << std::endl;
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = fileMapping ? MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_MAP " << path << std::endl;
+        if (fileMapping)
+            CloseHandle(fileMapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = fileMapping;
+    mapping = (const unsigned char*)view;
+    mappingSize = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_MAP " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_MAP " << path << std::endl;
+        return false;
+    }
+    // Everything in the pack is needed at startup, start reading ahead now
+    madvise(view, info.st_size, MADV_WILLNEED);
+    mapping = (const unsigned char*)view;
+    mappingSize = (size_t)info.st_size;
+#endif
+
+    // Header: magic, version, entry count
+    const size_t headerSize = 4 + 4 + 4;
+    uint32_t version = 0, count = 0;
+    if (mappingSize < headerSize || memcmp(mapping, PACK_MAGIC, 4) != 0) {
+        std::cerr << "ERROR::ASSET_PACK::INVALID " << path << std::endl;
+        close();
+        return false;
+    }
+    memcpy(&version, mapping + 4, 4);
+    memcpy(&count, mapping + 8, 4);
+    if (version != PACK_VERSION) {
+        std::cerr << "ERROR::ASSET_PACK::UNSUPPORTED_VERSION " << path << std::endl;
+        close();
+        return false;
+    }
+
+    size_t cursor = headerSize;
+    for (uint32_t i = 0; i < count; ++i) {
+        Entry entry;
+        uint32_t nameLength = 0;
+        if (cursor + 20 > mappingSize)
+            break;
+        memcpy(&entry.offset, mapping + cursor, 8);
+        memcpy(&entry.size, mapping + cursor + 8, 8);
+        memcpy(&nameLength, mapping + cursor + 16, 4);
+        cursor += 20;
+        // Compared without adding offset and size, which could wrap around
+        if (nameLength > mappingSize - cursor || entry.offset > mappingSize || entry.size > mappingSize - entry.offset)
+            break;
+        entries[std::string((const char*)mapping + cursor, nameLength)] = entry;
+        cursor += nameLength;
+    }
+    if (entries.size() != count) {
+        std::cerr << "ERROR::ASSET_PACK::TRUNCATED " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close() {
+    if (mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+        CloseHandle((HANDLE)mappingHandle);
+        CloseHandle((HANDLE)fileHandle);
+        mappingHandle = fileHandle = nullptr;
+#else
+        munmap((void*)mapping, mappingSize);
+#endif
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    entries.clear();
+}
+
+const unsigned char* AssetPack::find(const std::string& name, size_t& size) const {
+    auto it = entries.find(name);
+    if (it == entries.end())
+        return nullptr;
+    size = (size_t)it->second.size;
+    return mapping + it->second.offset;
+}
+
+bool buildAssetPack(const char* packPath, const std::vector<std::string>& files) {
+    // Index size decides where the first blob starts
+    uint64_t indexEnd = 4 + 4 + 4;
+    for (const std::string& name : files)
+        indexEnd += 20 + name.size();
+
+    std::vector<uint64_t> offsets, sizes;
+    uint64_t offset = indexEnd;
+    for (const std::string& name : files) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(name, error);
+        if (error) {
+            std::cerr << "ERROR::ASSET_PACK::MISSING_FILE " << name << std::endl;
+            return false;
+        }
+        offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+        offsets.push_back(offset);
+        sizes.push_back(size);
+        offset += size;
+    }
+
+    std::ofstream pack(packPath, std::ios::binary);
+    if (!pack) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_WRITE " << packPath << std::endl;
+        return false;
+    }
+    uint32_t count = (uint32_t)files.size();
+    pack.write(PACK_MAGIC, 4);
+    pack.write((const char*)&PACK_VERSION, 4);
+    pack.write((const char*)&count, 4);
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t nameLength = (uint32_t)files[i].size();
+        pack.write((const char*)&offsets[i], 8);
+        pack.write((const char*)&sizes[i], 8);
+        pack.write((const char*)&nameLength, 4);
+        pack.write(files[i].data(), nameLength);
+    }
+
+    std::vector<char> buffer;
+    for (size_t i = 0; i < files.size(); ++i) {
+        // Zero padding up to the blob's aligned offset
+        uint64_t position = (uint64_t)pack.tellp();
+        buffer.assign((size_t)(offsets[i] - position), 0);
+        pack.write(buffer.data(), buffer.size());
+
+        std::ifstream file(files[i], std::ios::binary);
+        buffer.resize((size_t)sizes[i]);
+        file.read(buffer.data(), buffer.size());
+        pack.write(buffer.data(), buffer.size());
+    }
+    if (!pack) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_WRITE " << packPath << std::endl;
+        return false;
+    }
+    std::clog << "Packed " << files.size() << " files into " << packPath << " (" << offset / (1024.0 * 1024.0) << " MB)" << std::endl;
+    return true;
+}
+
+std::vector<std::string> defaultAssetFiles() {
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("textures", error)) {
+        std::string extension = entry.path().extension().string();
+        if (entry.is_regular_file() && extension != ".tmp")
+            files.push_back(entry.path().generic_string());
+    }
+    for (const auto& entry : std::filesystem::directory_iterator("scenes", error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json")
+            files.push_back(entry.path().generic_string());
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(".", error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".glsl")
+            files.push_back(entry.path().filename().generic_string());
+    }
+    if (std::filesystem::exists("glowing.png"))
+        files.push_back("glowing.png");
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static AssetPack mountedPack;
+static bool packMounted = false;
+
+bool mountAssetPack(const char* path) {
+    packMounted = mountedPack.open(path);
+    return packMounted;
+}
+
+const unsigned char* findAsset(const std::string& name, size_t& size) {
+    if (!packMounted)
+        return nullptr;
+    return mountedPack.find(name, size);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Single-file asset archive. Layout:
+//   header   "APK1", version, entry count
+//   index    per entry: offset, size, name length, name ("textures/earth.jpg")
+//   blobs    file contents, each starting on a 4 KB boundary
+// The pack is memory mapped read-only, so loading it is one open() and
+// asset data is handed to decoders and GL uploads straight from the
+// mapping without any copy; the OS page cache does the rest.
+
+class AssetPack {
+public:
+    AssetPack() = default;
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+    ~AssetPack();
+
+    bool open(const char* path);
+    void close();
+
+    // Returns the mapped contents of an asset, nullptr when not packed
+    const unsigned char* find(const std::string& name, size_t& size) const;
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const unsigned char* mapping = nullptr;
+    size_t mappingSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    std::unordered_map<std::string, Entry> entries;
+};
+
+// Writes a pack containing the given files, stored under their relative path
+bool buildAssetPack(const char* packPath, const std::vector<std::string>& files);
+
+// Default contents: textures/ (including generated .dds caches), scenes/*.json,
+// glowing.png and every .glsl shader of the working directory
+std::vector<std::string> defaultAssetFiles();
+
+// The pack assets are looked up in first; without one (or for files it
+// does not contain) loaders fall back to reading the file system
+bool mountAssetPack(const char* path);
+const unsigned char* findAsset(const std::string& name, size_t& size);
@@ -0,0 +1,102 @@
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include "Belt.h"
+
+std::vector<BeltInstance> generateBelt(const SceneBelt& belt, float density) {
+    int count = (int)std::lround(belt.count * density);
+    std::vector<BeltInstance> instances(count > 0 ? count : 0);
+
+    std::mt19937 random(belt.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    // The spread has to be positive, a flat belt never samples it
+    std::normal_distribution<float> tilt(0.0f, belt.inclination > 0.0f ? belt.inclination * 0.5f : 1.0f);
+    const float twoPi = 2.0f * glm::pi<float>();
+    for (BeltInstance& instance : instances) {
+        // Uniform over the annulus area, so the inner edge is not crowded
+        float inner2 = belt.innerRadius * belt.innerRadius;
+        float outer2 = belt.outerRadius * belt.outerRadius;
+        float radius = std::sqrt(inner2 + unit(random) * (outer2 - inner2));
+        // Kepler's third law: angular speed falls with radius^1.5
+        float speed = belt.orbitSpeed * std::pow(belt.innerRadius / radius, 1.5f);
+        // Mostly small bodies, a few larger ones
+        float size = unit(random);
+        float scale = belt.minScale + (belt.maxScale - belt.minScale) * size * size;
+
+        float inclination = 0.0f;
+        if (belt.inclination > 0.0f)
+            inclination = glm::clamp(tilt(random), -belt.inclination, belt.inclination);
+        instance.orbit = glm::vec4(radius, unit(random) * twoPi, speed, scale);
+        instance.plane = glm::vec2(inclination, unit(random) * twoPi);
+    }
+    return instances;
+}
+
+void advanceBeltPhases(std::vector<BeltInstance>& instances, double elapsed) {
+    const double twoPi = 2.0 * glm::pi<double>();
+    for (BeltInstance& instance : instances) {
+        // The float speed the shader multiplies with, so nothing jumps
+        double phase = instance.orbit.y + (double)instance.orbit.z * elapsed;
+        instance.orbit.y = (float)(phase - twoPi * std::floor(phase / twoPi));
+    }
+}
+
+Belt createBelt(const SceneBelt& sceneBelt, const SphereMeshSet& mesh, float density) {
+    Belt belt;
+    belt.instances = generateBelt(sceneBelt, density);
+    const std::vector<BeltInstance>& instances = belt.instances;
+    belt.count = (int)instances.size();
+    belt.outerRadius = sceneBelt.outerRadius;
+    belt.textureLayer = (float)sceneBelt.textureLayer;
+    glGenVertexArrays(1, &belt.VAO);
+    glGenBuffers(1, &belt.instanceVBO);
+
+    glBindVertexArray(belt.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    setVertexAttributes(mesh.format);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+
+    // Only the phases change, and only when the epoch moves
+    glBindBuffer(GL_ARRAY_BUFFER, belt.instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(BeltInstance), instances.data(), GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(BeltInstance), (void*)offsetof(BeltInstance, orbit));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(BeltInstance), (void*)offsetof(BeltInstance, plane));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    glBindVertexArray(0);
+    return belt;
+}
+
+void deleteBelt(Belt& belt) {
+    glDeleteVertexArrays(1, &belt.VAO);
+    glDeleteBuffers(1, &belt.instanceVBO);
+    belt.VAO = belt.instanceVBO = 0;
+    belt.count = 0;
+    belt.instances.clear();
+}
+
+bool updateBeltEpoch(Belt& belt, double time) {
+    if (std::abs(time - belt.epoch) <= BELT_EPOCH_SPAN)
+        return false;
+    advanceBeltPhases(belt.instances, time - belt.epoch);
+    belt.epoch = time;
+    if (belt.count > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, belt.instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, belt.instances.size() * sizeof(BeltInstance), belt.instances.data());
+    }
+    return true;
+}
+
+void drawBelt(const Belt& belt, const SphereMeshSet& mesh) {
+    if (belt.count == 0)
+        return;
+    const SphereLOD& lod = mesh.levels[0];
+    glBindVertexArray(belt.VAO);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.indexCount, mesh.indexType,
+        (void*)((size_t)lod.firstIndex * mesh.indexSize), belt.count, lod.baseVertex);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Scene.h"
+#include "SphereMesh.h"
+
+// Belts of small bodies (asteroid belt, Kuiper belt) drawn as instances of
+// the coarsest sphere LOD. Every instance only holds its orbital elements;
+// belt_vertex_shader.glsl places it from the time since the belt's epoch.
+//
+// That time is a float, exact to half a millisecond only for the first
+// BELT_EPOCH_SPAN seconds. Past it (or before, running backwards) the
+// phases are moved to the current time on the CPU in double precision and
+// the epoch follows, so any time and any time warp stays as exact as the
+// first hour. At 1x that is one rebase an hour, at high warps one a frame.
+struct BeltInstance {
+    glm::vec4 orbit;  // radius, phase, angular speed (rad/s), scale
+    glm::vec2 plane;  // inclination, longitude of the ascending node
+};
+
+const double BELT_EPOCH_SPAN = 4096.0;
+
+struct Belt {
+    unsigned int VAO = 0;
+    unsigned int instanceVBO = 0;
+    int count = 0;
+    // CPU copy of the instance buffer, phases at the epoch
+    std::vector<BeltInstance> instances;
+    double epoch = 0.0;
+    float outerRadius = 0.0f;
+    float textureLayer = 0.0f;
+};
+
+// Deterministic for a given seed. density scales the scene's count.
+std::vector<BeltInstance> generateBelt(const SceneBelt& belt, float density);
+// Moves every phase elapsed seconds along its orbit, in double precision
+void advanceBeltPhases(std::vector<BeltInstance>& instances, double elapsed);
+
+// Shares the sphere mesh's vertex and index buffers (attributes 0-2),
+// instance attributes are 3 and 4
+Belt createBelt(const SceneBelt& belt, const SphereMeshSet& mesh, float density);
+void deleteBelt(Belt& belt);
+// Rebases the belt to the given time once it is more than BELT_EPOCH_SPAN
+// seconds from the epoch and uploads the new phases. True when it did.
+bool updateBeltEpoch(Belt& belt, double time);
+
+// Expects the belt shader to be bound, with the time since belt.epoch set
+void drawBelt(const Belt& belt, const SphereMeshSet& mesh);
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "Bench.h"
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "update",
+    "setup",
+    "orbits",
+    "planets",
+    "belts",
+    "swap"
+};
+
+FrameBenchmark::FrameBenchmark(int warmupFrames) : warmup(warmupFrames) {
+}
+
+void FrameBenchmark::beginFrame() {
+    frameStart = Clock::now();
+    phaseStart = frameStart;
+    for (int i = 0; i < PHASE_COUNT; ++i)
+        currentPhases[i] = 0.0;
+}
+
+void FrameBenchmark::endPhase(BenchPhase phase) {
+    Clock::time_point now = Clock::now();
+    currentPhases[phase] += std::chrono::duration<double, std::milli>(now - phaseStart).count();
+    phaseStart = now;
+}
+
+void FrameBenchmark::endFrame() {
+    Clock::time_point now = Clock::now();
+    // Warm-up frames (shader/texture first use, driver caches) are not recorded
+    if (frameIndex++ < warmup)
+        return;
+    for (int i = 0; i < PHASE_COUNT; ++i)
+        phaseTimes[i].push_back(currentPhases[i]);
+    frameTimes.push_back(std::chrono::duration<double, std::milli>(now - frameStart).count());
+}
+
+void FrameBenchmark::setValue(const std::string& name, double value) {
+    for (auto& v : values) {
+        if (v.first == name) {
+            v.second = value;
+            return;
+        }
+    }
+    values.push_back(std::make_pair(name, value));
+}
+
+// Writes text as a quoted JSON string
+static void writeString(std::ostream& out, const std::string& text) {
+    static const char hex[] = "0123456789abcdef";
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+static void writeStats(std::ostream& out, const char* name, std::vector<double> samples) {
+    double minValue = 0.0, median = 0.0, p99 = 0.0, mean = 0.0;
+    if (!samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        size_t n = samples.size();
+        minValue = samples[0];
+        median = samples[(n - 1) / 2];
+        // Nearest-rank percentile
+        size_t rank = (size_t)std::ceil(0.99 * n);
+        p99 = samples[std::max<size_t>(rank, 1) - 1];
+        for (double s : samples)
+            mean += s;
+        mean /= n;
+    }
+    out << "    \"" << name << "\": { \"min_ms\": " << minValue
+        << ", \"median_ms\": " << median
+        << ", \"p99_ms\": " << p99
+        << ", \"mean_ms\": " << mean << " }";
+}
+
+bool FrameBenchmark::writeJSON(const char* path, const std::string& renderer, float timestep) const {
+    std::ofstream file;
+    if (path) {
+        file.open(path);
+        if (!file) {
+            std::cerr << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = path ? file : std::cout;
+
+    out << "{\n";
+    out << "  \"renderer\": ";
+    writeString(out, renderer);
+    out << ",\n";
+    out << "  \"frames\": " << frameTimes.size() << ",\n";
+    out << "  \"warmup_frames\": " << warmup << ",\n";
+    out << "  \"timestep\": " << timestep << ",\n";
+    for (const auto& v : values)
+        out << "  \"" << v.first << "\": " << v.second << ",\n";
+    out << "  \"phases\": {\n";
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        writeStats(out, phaseNames[i], phaseTimes[i]);
+        out << ",\n";
+    }
+    writeStats(out, "frame", frameTimes);
+    out << "\n  }\n}\n";
+    return true;
+}
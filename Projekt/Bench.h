@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+
+// Frame benchmark: collects per-phase CPU wall-clock times for every frame
+// and reports min/median/p99 as JSON so runs can be compared across builds.
+
+enum BenchPhase {
+    PHASE_UPDATE,   // simulation update
+    PHASE_SETUP,    // clear + per-frame uniforms
+    PHASE_ORBITS,   // orbit lines
+    PHASE_PLANETS,  // planets, rings and moons
+    PHASE_BELTS,    // asteroid and Kuiper belt instances
+    PHASE_SWAP,     // buffer swap (glFinish when headless)
+    PHASE_COUNT
+};
+
+class FrameBenchmark {
+public:
+    explicit FrameBenchmark(int warmupFrames = 0);
+
+    void beginFrame();
+    // Closes the running phase and starts timing the next one
+    void endPhase(BenchPhase phase);
+    void endFrame();
+
+    // Extra named numbers reported next to the timings (counts, startup times...)
+    void setValue(const std::string& name, double value);
+
+    int recordedFrames() const { return (int)frameTimes.size(); }
+    bool writeJSON(const char* path, const std::string& renderer, float timestep) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    int warmup;
+    int frameIndex = 0;
+    Clock::time_point frameStart;
+    Clock::time_point phaseStart;
+    double currentPhases[PHASE_COUNT] = {};
+    std::vector<double> phaseTimes[PHASE_COUNT];
+    std::vector<double> frameTimes;
+    std::vector<std::pair<std::string, double>> values;
+};
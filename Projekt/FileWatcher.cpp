@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include "FileWatcher.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// "vertex_shader.glsl" -> "", "shaders/a.glsl" -> "shaders/"
+static std::string directoryPrefix(const std::string& file) {
+    std::string parent = std::filesystem::path(file).parent_path().generic_string();
+    return parent.empty() ? parent : parent + "/";
+}
+#endif
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::start(const std::vector<std::string>& watchedFiles) {
+    stop();
+    files.clear();
+    for (const std::string& file : watchedFiles)
+        files.push_back(std::filesystem::path(file).generic_string());
+
+#if defined(__linux__)
+    inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFD < 0) {
+        std::cerr << "ERROR::FILE_WATCHER::INOTIFY_UNAVAILABLE" << std::endl;
+        return false;
+    }
+    for (const std::string& file : files) {
+        std::string prefix = directoryPrefix(file);
+        auto known = std::find_if(directories.begin(), directories.end(),
+            [&prefix](const std::pair<int, std::string>& entry) { return entry.second == prefix; });
+        if (known != directories.end())
+            continue;
+
+        int watch = inotify_add_watch(inotifyFD, prefix.empty() ? "." : prefix.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0)
+            std::cerr << "ERROR::FILE_WATCHER::CANNOT_WATCH " << (prefix.empty() ? "." : prefix) << std::endl;
+        else
+            directories.emplace_back(watch, prefix);
+    }
+#endif
+
+    running = true;
+    thread = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+void FileWatcher::stop() {
+    running = false;
+    if (thread.joinable())
+        thread.join();
+#if defined(__linux__)
+    if (inotifyFD >= 0)
+        close(inotifyFD);
+    inotifyFD = -1;
+    directories.clear();
+#endif
+}
+
+std::vector<std::string> FileWatcher::takeChanged() {
+    std::vector<std::string> result;
+    std::lock_guard<std::mutex> lock(changedMutex);
+    result.swap(changed);
+    return result;
+}
+
+void FileWatcher::markChanged(const std::string& file) {
+    if (std::find(files.begin(), files.end(), file) == files.end())
+        return;
+    std::lock_guard<std::mutex> lock(changedMutex);
+    if (std::find(changed.begin(), changed.end(), file) == changed.end())
+        changed.push_back(file);
+}
+
+#if defined(__linux__)
+void FileWatcher::run() {
+    alignas(inotify_event) char buffer[4096];
+    pollfd descriptor = { inotifyFD, POLLIN, 0 };
+    while (running) {
+        // Wake up regularly to notice stop()
+        if (poll(&descriptor, 1, 200) <= 0)
+            continue;
+
+        ssize_t length;
+        while ((length = read(inotifyFD, buffer, sizeof(buffer))) > 0) {
+            for (char* cursor = buffer; cursor < buffer + length;) {
+                const inotify_event* event = (const inotify_event*)cursor;
+                cursor += sizeof(inotify_event) + event->len;
+                if (event->len == 0)
+                    continue;
+                for (const auto& directory : directories) {
+                    if (directory.first == event->wd)
+                        markChanged(directory.second + event->name);
+                }
+            }
+        }
+    }
+}
+#else
+void FileWatcher::run() {
+    std::vector<std::filesystem::file_time_type> times(files.size());
+    std::error_code error;
+    for (size_t i = 0; i < files.size(); ++i)
+        times[i] = std::filesystem::last_write_time(files[i], error);
+
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        for (size_t i = 0; i < files.size(); ++i) {
+            auto time = std::filesystem::last_write_time(files[i], error);
+            if (!error && time != times[i]) {
+                times[i] = time;
+                markChanged(files[i]);
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches a set of files on a background thread and reports the ones that
+// were modified. Linux uses inotify on the containing directories, since
+// editors often save by writing a new file and renaming it over the old
+// one, which a watch on the file itself would lose. Other platforms poll
+// the modification times a few times per second.
+class FileWatcher {
+public:
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    ~FileWatcher();
+
+    bool start(const std::vector<std::string>& files);
+    void stop();
+
+    // Files modified since the last call, each listed once
+    std::vector<std::string> takeChanged();
+
+private:
+    void run();
+    void markChanged(const std::string& file);
+
+    std::vector<std::string> files;
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::mutex changedMutex;
+    std::vector<std::string> changed;
+#if defined(__linux__)
+    int inotifyFD = -1;
+    std::vector<std::pair<int, std::string>> directories;
+#endif
+};
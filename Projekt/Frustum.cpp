@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cmath>
+#include "Frustum.h"
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+    // Gribb/Hartmann: clip space planes are sums and differences of the
+    // rows of the matrix (glm is column-major, so row i is m[*][i])
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];  // left
+    frustum.planes[1] = rows[3] - rows[0];  // right
+    frustum.planes[2] = rows[3] + rows[1];  // bottom
+    frustum.planes[3] = rows[3] - rows[1];  // top
+    frustum.planes[4] = rows[3] + rows[2];  // near
+    frustum.planes[5] = rows[3] - rows[2];  // far
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+    for (const glm::vec4& plane : frustum.planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool horizontalDiscInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+    for (const glm::vec4& plane : frustum.planes) {
+        // The disc point furthest along the normal is radius away from the
+        // center in the direction of the normal's xz part
+        float extent = radius * std::sqrt(plane.x * plane.x + plane.z * plane.z);
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -extent)
+            return false;
+    }
+    return true;
+}
+
+bool discInFrustum(const Frustum& frustum, const glm::vec3& center, const glm::vec3& normal, float radius) {
+    for (const glm::vec4& plane : frustum.planes) {
+        // Same as above with the plane normal's part within the disc's plane
+        float along = glm::dot(glm::vec3(plane), normal);
+        float extent = radius * std::sqrt(std::max(0.0f, 1.0f - along * along));
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -extent)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (xyz = unit normal, w = distance),
+// extracted from a projection * view matrix, so "inside" means the
+// signed distance is >= 0 for all six.
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// Conservative tests: false only when the volume is entirely outside one
+// of the planes
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+// Disc (or circle) of the given radius lying in a horizontal (xz) plane,
+// like the orbits and Saturn's ring. Much tighter than the bounding sphere
+// when the camera looks across the plane.
+bool horizontalDiscInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+// Disc in any plane, given by its unit normal, like inclined orbits
+bool discInFrustum(const Frustum& frustum, const glm::vec3& center, const glm::vec3& normal, float radius);
+
+// Drawn/culled counters of one kind of object, reset every frame
+struct CullStats {
+    int drawn = 0;
+    int culled = 0;
+
+    void reset() { drawn = culled = 0; }
+    // Counts the object and passes visible through
+    bool count(bool visible) {
+        if (visible)
+            ++drawn;
+        else
+            ++culled;
+        return visible;
+    }
+};
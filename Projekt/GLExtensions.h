@@ -0,0 +1,5 @@
+#pragma once
+
+// True when the current context advertises the extension (GL_NUM_EXTENSIONS
+// / glGetStringi, the only query available in a core profile)
+bool hasExtension(const char* name);
@@ -0,0 +1,168 @@
+#include <glad/glad.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include "Headless.h"
+
+#if defined(__linux__)
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+bool createHeadlessContext(HeadlessContext& ctx) {
+    // Prefer the surfaceless platform so no X11/Wayland server is needed
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cerr << "ERROR::HEADLESS::EGL_INITIALIZE_FAILED" << std::endl;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "ERROR::HEADLESS::EGL_OPENGL_API_UNAVAILABLE" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        std::cerr << "ERROR::HEADLESS::EGL_NO_MATCHING_CONFIG" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    // Same context version as the windowed path (3.3 core)
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "ERROR::HEADLESS::EGL_CREATE_CONTEXT_FAILED" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    // No surface at all, everything is rendered into our own FBO
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "ERROR::HEADLESS::EGL_MAKE_CURRENT_FAILED" << std::endl;
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    ctx.display = display;
+    ctx.context = context;
+    return true;
+}
+
+void* headlessGetProcAddress(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+void destroyHeadlessContext(HeadlessContext& ctx) {
+    if (ctx.FBO) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &ctx.FBO);
+        glDeleteRenderbuffers(1, &ctx.colorRBO);
+        glDeleteRenderbuffers(1, &ctx.depthRBO);
+        ctx.FBO = ctx.colorRBO = ctx.depthRBO = 0;
+    }
+    if (ctx.display) {
+        eglMakeCurrent((EGLDisplay)ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (ctx.context)
+            eglDestroyContext((EGLDisplay)ctx.display, (EGLContext)ctx.context);
+        eglTerminate((EGLDisplay)ctx.display);
+    }
+    ctx.display = nullptr;
+    ctx.context = nullptr;
+}
+
+#else
+
+bool createHeadlessContext(HeadlessContext& ctx) {
+    std::cerr << "ERROR::HEADLESS::NOT_SUPPORTED_ON_THIS_PLATFORM" << std::endl;
+    return false;
+}
+
+void* headlessGetProcAddress(const char* name) {
+    return nullptr;
+}
+
+void destroyHeadlessContext(HeadlessContext& ctx) {
+    if (ctx.FBO) {
+        glDeleteFramebuffers(1, &ctx.FBO);
+        glDeleteRenderbuffers(1, &ctx.colorRBO);
+        glDeleteRenderbuffers(1, &ctx.depthRBO);
+        ctx.FBO = ctx.colorRBO = ctx.depthRBO = 0;
+    }
+}
+
+#endif
+
+bool createHeadlessFramebuffer(HeadlessContext& ctx, int width, int height) {
+    glGenFramebuffers(1, &ctx.FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx.FBO);
+
+    glGenRenderbuffers(1, &ctx.colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx.colorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ctx.colorRBO);
+
+    glGenRenderbuffers(1, &ctx.depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx.depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, ctx.depthRBO);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        return false;
+    }
+
+    // Default draw/read buffer of a surfaceless context is GL_NONE
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    ctx.width = width;
+    ctx.height = height;
+    return true;
+}
+
+bool writeFramebufferPPM(const char* path, int width, int height) {
+    std::vector<unsigned char> pixels(width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR::HEADLESS::CANNOT_WRITE_IMAGE " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    // OpenGL rows start at the bottom, PPM rows at the top
+    for (int y = height - 1; y >= 0; --y) {
+        file.write((const char*)&pixels[y * width * 3], width * 3);
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Headless (window-less) rendering support.
+// On Linux an OpenGL 3.3 core context is created through EGL without any
+// window system (Mesa surfaceless platform, so llvmpipe works on GPU-less
+// machines; set LIBGL_ALWAYS_SOFTWARE=1 to force it) and the scene is drawn
+// into an offscreen framebuffer object. Link with -lEGL.
+
+struct HeadlessContext {
+    void* display = nullptr;
+    void* context = nullptr;
+    unsigned int FBO = 0;
+    unsigned int colorRBO = 0;
+    unsigned int depthRBO = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Creates the EGL context and makes it current. GL functions are not
+// available until GLAD has been loaded with headlessGetProcAddress.
+bool createHeadlessContext(HeadlessContext& ctx);
+void* headlessGetProcAddress(const char* name);
+
+// Creates and binds the offscreen render target (requires a loaded GL).
+bool createHeadlessFramebuffer(HeadlessContext& ctx, int width, int height);
+
+// Reads back the currently bound framebuffer and writes it as a binary PPM.
+bool writeFramebufferPPM(const char* path, int width, int height);
+
+void destroyHeadlessContext(HeadlessContext& ctx);
@@ -0,0 +1,186 @@
+#include <cstdlib>
+#include <cstring>
+#include "Json.h"
+
+const JsonValue* JsonValue::find(const std::string& name) const {
+    if (type != OBJECT)
+        return nullptr;
+    for (const auto& member : members) {
+        if (member.first == name)
+            return &member.second;
+    }
+    return nullptr;
+}
+
+double JsonValue::getNumber(const std::string& name, double fallback) const {
+    const JsonValue* value = find(name);
+    return value && value->type == NUMBER ? value->number : fallback;
+}
+
+bool JsonValue::getBool(const std::string& name, bool fallback) const {
+    const JsonValue* value = find(name);
+    return value && value->type == BOOLEAN ? value->boolean : fallback;
+}
+
+std::string JsonValue::getString(const std::string& name, const std::string& fallback) const {
+    const JsonValue* value = find(name);
+    return value && value->type == STRING ? value->string : fallback;
+}
+
+// Recursive descent over the whole text, stops at the first error
+struct JsonParser {
+    const std::string& text;
+    size_t position = 0;
+    std::string error;
+
+    explicit JsonParser(const std::string& source) : text(source) {}
+
+    bool fail(const char* message) {
+        if (error.empty()) {
+            int line = 1;
+            for (size_t i = 0; i < position && i < text.size(); ++i)
+                line += text[i] == '\n';
+            error = std::string(message) + " at line " + std::to_string(line);
+        }
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (position < text.size() && strchr(" \t\r\n", text[position]))
+            ++position;
+    }
+
+    bool expect(char c) {
+        skipWhitespace();
+        if (position >= text.size() || text[position] != c)
+            return fail(c == '}' || c == ']' ? "missing closing bracket or comma" : "unexpected character");
+        ++position;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (!expect('"'))
+            return false;
+        out.clear();
+        while (position < text.size() && text[position] != '"') {
+            char c = text[position++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (position >= text.size())
+                break;
+            char escaped = text[position++];
+            switch (escaped) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                if (position + 4 > text.size())
+                    return fail("bad \\u escape");
+                unsigned long code = strtoul(text.substr(position, 4).c_str(), nullptr, 16);
+                position += 4;
+                // UTF-8 encode, surrogate pairs are not needed for file names
+                if (code < 0x80) {
+                    out += (char)code;
+                }
+                else if (code < 0x800) {
+                    out += (char)(0xC0 | (code >> 6));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                else {
+                    out += (char)(0xE0 | (code >> 12));
+                    out += (char)(0x80 | ((code >> 6) & 0x3F));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: out += escaped; break;
+            }
+        }
+        if (position >= text.size())
+            return fail("unterminated string");
+        ++position;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value) {
+        skipWhitespace();
+        if (position >= text.size())
+            return fail("unexpected end of file");
+
+        char c = text[position];
+        if (c == '{') {
+            ++position;
+            value.type = JsonValue::OBJECT;
+            skipWhitespace();
+            if (position < text.size() && text[position] == '}') {
+                ++position;
+                return true;
+            }
+            do {
+                std::pair<std::string, JsonValue> member;
+                if (!parseString(member.first) || !expect(':') || !parseValue(member.second))
+                    return false;
+                value.members.push_back(std::move(member));
+                skipWhitespace();
+            } while (position < text.size() && text[position] == ',' && ++position);
+            return expect('}');
+        }
+        if (c == '[') {
+            ++position;
+            value.type = JsonValue::ARRAY;
+            skipWhitespace();
+            if (position < text.size() && text[position] == ']') {
+                ++position;
+                return true;
+            }
+            do {
+                value.array.emplace_back();
+                if (!parseValue(value.array.back()))
+                    return false;
+                skipWhitespace();
+            } while (position < text.size() && text[position] == ',' && ++position);
+            return expect(']');
+        }
+        if (c == '"') {
+            value.type = JsonValue::STRING;
+            return parseString(value.string);
+        }
+        if (text.compare(position, 4, "true") == 0 || text.compare(position, 5, "false") == 0) {
+            value.type = JsonValue::BOOLEAN;
+            value.boolean = c == 't';
+            position += value.boolean ? 4 : 5;
+            return true;
+        }
+        if (text.compare(position, 4, "null") == 0) {
+            value.type = JsonValue::NUL;
+            position += 4;
+            return true;
+        }
+
+        const char* start = text.c_str() + position;
+        char* end = nullptr;
+        value.number = strtod(start, &end);
+        if (end == start)
+            return fail("unexpected character");
+        value.type = JsonValue::NUMBER;
+        position += end - start;
+        return true;
+    }
+};
+
+bool parseJson(const std::string& text, JsonValue& root, std::string& error) {
+    JsonParser parser(text);
+    root = JsonValue();
+    bool parsed = parser.parseValue(root);
+    if (parsed) {
+        parser.skipWhitespace();
+        if (parser.position != text.size())
+            parsed = parser.fail("trailing characters");
+    }
+    error = parser.error;
+    return parsed;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document model for the scene files: numbers are doubles,
+// object members keep their file order.
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    // Member lookup, nullptr when missing or not an object
+    const JsonValue* find(const std::string& name) const;
+    // Typed member access with a default for missing members
+    double getNumber(const std::string& name, double fallback) const;
+    bool getBool(const std::string& name, bool fallback) const;
+    std::string getString(const std::string& name, const std::string& fallback) const;
+};
+
+// Parses text into root. On failure error holds the reason and line.
+bool parseJson(const std::string& text, JsonValue& root, std::string& error);
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include "MeshOptimization.h"
+
+static const int FORSYTH_CACHE_SIZE = 32;
+
+static float vertexScore(int cachePosition, int remainingTriangles) {
+    // No triangle left to emit: the vertex is worthless
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // The three vertices of the last triangle get a fixed score so the
+        // next triangle does not simply reuse them again and again
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (float)(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    // Prefer vertices with few triangles left, so they can leave the cache
+    score += 2.0f / std::sqrt((float)remainingTriangles);
+    return score;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, int vertexCount) {
+    int triangleCount = (int)indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles using each vertex, as one flat adjacency array
+    std::vector<int> remaining(vertexCount, 0);
+    for (unsigned int index : indices)
+        ++remaining[index];
+    std::vector<int> adjacencyStart(vertexCount + 1, 0);
+    for (int v = 0; v < vertexCount; ++v)
+        adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    std::vector<int> adjacency(indices.size());
+    std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (int t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (int t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<int> cache, nextCache;
+    int scanCursor = 0;
+    int best = (int)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+
+    while (best >= 0) {
+        emitted[best] = true;
+        const unsigned int* triangle = &indices[best * 3];
+        for (int k = 0; k < 3; ++k)
+            result.push_back(triangle[k]);
+
+        // The emitted vertices move to the front of the cache
+        nextCache.assign(triangle, triangle + 3);
+        for (int v : cache) {
+            if (v != (int)triangle[0] && v != (int)triangle[1] && v != (int)triangle[2])
+                nextCache.push_back(v);
+        }
+        for (int k = 0; k < 3; ++k) {
+            int v = triangle[k];
+            --remaining[v];
+            // Drop the triangle from the vertex's live adjacency
+            int* first = &adjacency[adjacencyStart[v]];
+            int* last = first + remaining[v] + 1;
+            std::swap(*std::find(first, last, best), *(last - 1));
+        }
+
+        // Rescore everything that was or is cached, and their triangles
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            int v = nextCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+        best = -1;
+        float bestScore = -1.0f;
+        for (int v : nextCache) {
+            for (int i = 0; i < remaining[v]; ++i) {
+                int t = adjacency[adjacencyStart[v] + i];
+                triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        if (nextCache.size() > FORSYTH_CACHE_SIZE)
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // Nothing adjacent to the cache is left: continue with any triangle
+        if (best < 0) {
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                ++scanCursor;
+            if (scanCursor < triangleCount)
+                best = scanCursor;
+        }
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<float>& vertices, int stride, std::vector<unsigned int>& indices) {
+    int vertexCount = (int)vertices.size() / stride;
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+    int next = 0;
+    for (unsigned int& index : indices) {
+        if (remap[index] < 0) {
+            remap[index] = next++;
+            reordered.insert(reordered.end(), vertices.begin() + index * stride, vertices.begin() + (index + 1) * stride);
+        }
+        index = remap[index];
+    }
+    // Unreferenced vertices are dropped
+    vertices.swap(reordered);
+}
+
+float computeACMR(const std::vector<unsigned int>& indices, int vertexCount, int cacheSize) {
+    if (indices.empty())
+        return 0.0f;
+
+    // FIFO: a vertex is in the cache while fewer than cacheSize misses
+    // happened since it was last loaded
+    std::vector<int> loadedAt(vertexCount, -cacheSize - 1);
+    int misses = 0;
+    for (unsigned int index : indices) {
+        if (misses - loadedAt[index] > cacheSize) {
+            loadedAt[index] = misses;
+            ++misses;
+        }
+    }
+    return (float)misses / (indices.size() / 3);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+
+// Index buffer post-processing for the GPU's post-transform vertex cache.
+// optimizeVertexCache reorders triangles with Tom Forsyth's linear-speed
+// algorithm: every vertex is scored by its position in a simulated LRU
+// cache and by how many of its triangles are still unemitted, and the
+// best-scoring triangle among those touching cached vertices goes next.
+// Vertices are then renumbered in first-use order for fetch locality.
+
+// Reorders the triangles of an indexed triangle list in place
+void optimizeVertexCache(std::vector<unsigned int>& indices, int vertexCount);
+
+// Renumbers vertices in the order the indices first reference them and
+// reorders the interleaved vertex data (stride floats per vertex) to match
+void optimizeVertexFetch(std::vector<float>& vertices, int stride, std::vector<unsigned int>& indices);
+
+// Average cache miss ratio: transformed vertices per triangle with a FIFO
+// cache of the given size. 3.0 is the worst case; about 0.6-0.7 is typical
+// for a well ordered closed mesh (the lower bound approaches 0.5).
+float computeACMR(const std::vector<unsigned int>& indices, int vertexCount, int cacheSize = 16);
@@ -0,0 +1,455 @@
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "NBody.h"
+
+// Cells with at most this many bodies are not split further
+static const int LEAF_SIZE = 8;
+// 21 bits per axis fill 63 bits of the Morton code
+static const int TREE_LEVELS = 21;
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void NBodySystem::add(const glm::dvec3& bodyPosition, const glm::dvec3& bodyVelocity, double bodyMass) {
+    id.push_back((int)position.size());
+    position.push_back(bodyPosition);
+    velocity.push_back(bodyVelocity);
+    acceleration.push_back(glm::dvec3(0.0));
+    mass.push_back(bodyMass);
+    potential.push_back(0.0);
+}
+
+// Spreads the low 21 bits of v so two zero bits follow each one
+static unsigned long long spreadBits(unsigned long long v) {
+    v &= 0x1FFFFF;
+    v = (v | (v << 32)) & 0x1F00000000FFFFULL;
+    v = (v | (v << 16)) & 0x1F0000FF0000FFULL;
+    v = (v | (v << 8)) & 0x100F00F00F00F00FULL;
+    v = (v | (v << 4)) & 0x10C30C30C30C30C3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+}
+
+// Stable LSD radix sort of the body order by Morton code, 11 bits per pass
+static void sortByCode(const std::vector<unsigned long long>& codes, std::vector<int>& order) {
+    const size_t count = codes.size();
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        order[i] = (int)i;
+    if (count < 2048) {
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return codes[a] < codes[b]; });
+        return;
+    }
+    std::vector<int> buffer(count);
+    std::vector<size_t> histogram(2048);
+    for (int shift = 0; shift < 3 * TREE_LEVELS; shift += 11) {
+        std::fill(histogram.begin(), histogram.end(), 0);
+        for (size_t i = 0; i < count; ++i)
+            ++histogram[(codes[i] >> shift) & 2047];
+        size_t offset = 0;
+        for (size_t& bucket : histogram) {
+            size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            int body = order[i];
+            buffer[histogram[(codes[body] >> shift) & 2047]++] = body;
+        }
+        order.swap(buffer);
+    }
+}
+
+template <typename T>
+static void permute(std::vector<T>& values, const std::vector<int>& order, std::vector<T>& scratch) {
+    scratch.resize(values.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        scratch[i] = values[order[i]];
+    values.swap(scratch);
+}
+
+// Fills nodes[index] with the cell holding bodies [first, first + count),
+// whose codes agree above the given level, and recurses into its octants.
+// Children are appended as one block before recursing, so they end up
+// consecutive; nodes may reallocate, hence no references are kept.
+static void buildNode(NBodySystem& system, int index, int first, int count, int level,
+    const glm::dvec3& center, double size) {
+    OctreeNode node;
+    node.center = center;
+    node.size = size;
+    node.firstBody = first;
+    node.bodyCount = count;
+    node.firstChild = -1;
+    node.childCount = 0;
+    node.mass = 0.0;
+    node.centerOfMass = glm::dvec3(0.0);
+
+    if (count > LEAF_SIZE && level < TREE_LEVELS) {
+        // Codes are sorted and share every bit above this level, so each
+        // octant is a contiguous run found by binary search
+        const int shift = 3 * (TREE_LEVELS - 1 - level);
+        const unsigned long long* codes = system.mortonCodes.data();
+        int starts[9];
+        for (int octant = 0; octant <= 8; ++octant) {
+            starts[octant] = (int)(std::lower_bound(codes + first, codes + first + count, (unsigned long long)octant,
+                [shift](unsigned long long code, unsigned long long value) { return ((code >> shift) & 7) < value; }) - codes);
+        }
+        starts[8] = first + count;
+
+        int children[8], childOctants[8];
+        for (int octant = 0; octant < 8; ++octant) {
+            if (starts[octant + 1] > starts[octant])
+                childOctants[node.childCount++] = octant;
+        }
+        node.firstChild = (int)system.nodes.size();
+        system.nodes.resize(system.nodes.size() + node.childCount);
+        for (int c = 0; c < node.childCount; ++c) {
+            int octant = childOctants[c];
+            children[c] = node.firstChild + c;
+            // Morton bit order is x lowest, then y, then z
+            glm::dvec3 offset((octant & 1) ? 0.25 : -0.25, (octant & 2) ? 0.25 : -0.25, (octant & 4) ? 0.25 : -0.25);
+            buildNode(system, children[c], starts[octant], starts[octant + 1] - starts[octant], level + 1,
+                center + offset * size, size * 0.5);
+        }
+        for (int c = 0; c < node.childCount; ++c) {
+            const OctreeNode& child = system.nodes[children[c]];
+            node.mass += child.mass;
+            node.centerOfMass += child.centerOfMass * child.mass;
+        }
+    }
+    else {
+        for (int i = first; i < first + count; ++i) {
+            node.mass += system.mass[i];
+            node.centerOfMass += system.position[i] * system.mass[i];
+        }
+    }
+    // Massless cells (test particles only) keep their geometric center
+    node.centerOfMass = node.mass > 0.0 ? node.centerOfMass / node.mass : center;
+    system.nodes[index] = node;
+}
+
+// Acceleration and potential at body i from the whole tree, returns the
+// number of interactions
+static size_t walkTree(const NBodySystem& system, size_t i, glm::dvec3& acceleration, double& potential) {
+    const OctreeNode* nodes = system.nodes.data();
+    const glm::dvec3 position = system.position[i];
+    const double theta2 = system.theta * system.theta;
+    const double softening2 = system.softening * system.softening;
+    glm::dvec3 sum(0.0);
+    double phi = 0.0;
+    size_t interactions = 0;
+
+    int stack[8 * TREE_LEVELS + 8];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const OctreeNode& node = nodes[stack[--top]];
+        if (node.mass <= 0.0)
+            continue;
+        glm::dvec3 d = node.centerOfMass - position;
+        double distance2 = glm::dot(d, d);
+        glm::dvec3 local = glm::abs(position - node.center);
+        bool inside = local.x <= 0.5 * node.size && local.y <= 0.5 * node.size && local.z <= 0.5 * node.size;
+        if (!inside && node.size * node.size < theta2 * distance2) {
+            // Far enough: the whole cell as one point mass
+            double inverse = 1.0 / std::sqrt(distance2 + softening2);
+            sum += d * (node.mass * inverse * inverse * inverse);
+            phi -= node.mass * inverse;
+            ++interactions;
+        }
+        else if (node.firstChild < 0) {
+            for (int j = node.firstBody; j < node.firstBody + node.bodyCount; ++j) {
+                if ((size_t)j == i)
+                    continue;
+                glm::dvec3 dj = system.position[j] - position;
+                double inverse = 1.0 / std::sqrt(glm::dot(dj, dj) + softening2);
+                sum += dj * (system.mass[j] * inverse * inverse * inverse);
+                phi -= system.mass[j] * inverse;
+            }
+            interactions += node.bodyCount;
+        }
+        else {
+            for (int c = 0; c < node.childCount; ++c)
+                stack[top++] = node.firstChild + c;
+        }
+    }
+    acceleration = sum * system.gravitationalConstant;
+    potential = phi * system.gravitationalConstant;
+    return interactions;
+}
+
+void computeForces(NBodySystem& system, TaskScheduler& scheduler, NBodyTimings* timings) {
+    const size_t count = system.size();
+    system.nodes.clear();
+    if (count == 0)
+        return;
+
+    // Bounding cube of all bodies
+    Clock::time_point start = Clock::now();
+    glm::dvec3 low = system.position[0], high = system.position[0];
+    for (const glm::dvec3& p : system.position) {
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+    }
+    double size = std::max(std::max(high.x - low.x, high.y - low.y), std::max(high.z - low.z, 1e-9)) * (1.0 + 1e-9);
+    glm::dvec3 center = low + glm::dvec3(size * 0.5);
+
+    // Morton codes, sort and reorder every per-body array
+    system.mortonCodes.resize(count);
+    // Power of two cells per edge, so the code bits split the cube exactly
+    // where the geometric octants do
+    const double cellsPerUnit = (1 << TREE_LEVELS) / size;
+    const double lastCell = (1 << TREE_LEVELS) - 1;
+    scheduler.parallelFor(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::dvec3 cell = glm::min((system.position[i] - low) * cellsPerUnit, glm::dvec3(lastCell));
+            system.mortonCodes[i] = spreadBits((unsigned long long)cell.x)
+                | (spreadBits((unsigned long long)cell.y) << 1)
+                | (spreadBits((unsigned long long)cell.z) << 2);
+        }
+    });
+    std::vector<int> order;
+    sortByCode(system.mortonCodes, order);
+    std::vector<glm::dvec3> vectorScratch;
+    std::vector<double> doubleScratch;
+    std::vector<int> intScratch;
+    std::vector<unsigned long long> codeScratch;
+    permute(system.position, order, vectorScratch);
+    permute(system.velocity, order, vectorScratch);
+    permute(system.mass, order, doubleScratch);
+    permute(system.id, order, intScratch);
+    permute(system.mortonCodes, order, codeScratch);
+    if (timings)
+        timings->sortMs += millisecondsSince(start);
+
+    start = Clock::now();
+    system.nodes.reserve(count / 2 + 16);
+    system.nodes.resize(1);
+    buildNode(system, 0, 0, (int)count, 0, center, size);
+    if (timings)
+        timings->buildMs += millisecondsSince(start);
+
+    // Every body walks the tree on its own, neighbours in the Morton order
+    // share most of their walk and the cells it touches
+    start = Clock::now();
+    std::atomic<size_t> interactions{ 0 };
+    scheduler.parallelFor(count, 64, [&](size_t begin, size_t end) {
+        size_t local = 0;
+        for (size_t i = begin; i < end; ++i)
+            local += walkTree(system, i, system.acceleration[i], system.potential[i]);
+        interactions += local;
+    });
+    system.interactionsPerBody = (double)interactions / count;
+    if (timings)
+        timings->forceMs += millisecondsSince(start);
+}
+
+void stepNBody(NBodySystem& system, double dt, TaskScheduler& scheduler, NBodyTimings* timings) {
+    // Half kick with the old forces and a full drift...
+    Clock::time_point start = Clock::now();
+    scheduler.parallelFor(system.size(), 8192, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            system.velocity[i] += system.acceleration[i] * (0.5 * dt);
+            system.position[i] += system.velocity[i] * dt;
+        }
+    });
+    double integrateMs = millisecondsSince(start);
+
+    computeForces(system, scheduler, timings);
+
+    // ...then the second half kick with the new ones
+    start = Clock::now();
+    scheduler.parallelFor(system.size(), 8192, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            system.velocity[i] += system.acceleration[i] * (0.5 * dt);
+    });
+    system.time += dt;
+    if (timings)
+        timings->integrateMs += integrateMs + millisecondsSince(start);
+}
+
+double totalEnergy(const NBodySystem& system) {
+    double kinetic = 0.0, potential = 0.0;
+    for (size_t i = 0; i < system.size(); ++i) {
+        kinetic += 0.5 * system.mass[i] * glm::dot(system.velocity[i], system.velocity[i]);
+        // Every pair is in two bodies' potentials
+        potential += 0.5 * system.mass[i] * system.potential[i];
+    }
+    return kinetic + potential;
+}
+
+double energyDrift(double startEnergy, double endEnergy) {
+    double change = std::abs(endEnergy - startEnergy);
+    return startEnergy != 0.0 ? change / std::abs(startEnergy) : change;
+}
+
+void moveToCenterOfMassFrame(NBodySystem& system) {
+    glm::dvec3 momentum(0.0), weightedPosition(0.0);
+    double totalMass = 0.0;
+    for (size_t i = 0; i < system.size(); ++i) {
+        momentum += system.velocity[i] * system.mass[i];
+        weightedPosition += system.position[i] * system.mass[i];
+        totalMass += system.mass[i];
+    }
+    if (totalMass <= 0.0)
+        return;
+    // Only the drift is removed: the scene stays centered where it was
+    glm::dvec3 drift = momentum / totalMass;
+    for (glm::dvec3& velocity : system.velocity)
+        velocity -= drift;
+}
+
+NBodySystem createNBodySystem(const OrbitState& orbits, const std::vector<double>& masses,
+    double gravitationalConstant, double time) {
+    NBodySystem system;
+    system.gravitationalConstant = gravitationalConstant;
+    system.time = time;
+
+    // Roots orbit the origin, where the bodies without an orbit (the Sun)
+    // sit; together they are the central mass
+    double centralMass = 0.0;
+    for (int root : orbits.roots) {
+        if (orbits.px[root] == 0.0f && orbits.py[root] == 0.0f && orbits.pz[root] == 0.0f)
+            centralMass += masses[root];
+    }
+
+    for (size_t i = 0; i < orbits.size(); ++i) {
+        glm::dvec3 p(orbits.px[i], orbits.py[i], orbits.pz[i]);
+        glm::dvec3 q(orbits.qx[i], orbits.qy[i], orbits.qz[i]);
+        double a = glm::length(p);
+        double e = orbits.eccentricity[i];
+        double eccentricAnomaly = solveKepler(orbits.meanAnomaly[i] + orbits.meanMotion[i] * time, e);
+        double sinE = std::sin(eccentricAnomaly), cosE = std::cos(eccentricAnomaly);
+        glm::dvec3 position = p * (cosE - e) + q * sinE;
+        glm::dvec3 velocity(0.0);
+        int parent = orbits.parent[i];
+        if (a > 0.0) {
+            // dr/dt = (-sin E p + cos E q) dE/dt, with dE/dt = n / (1 - e cos E)
+            double centerMass = parent >= 0 ? masses[parent] : centralMass;
+            double meanMotion = std::sqrt(gravitationalConstant * (centerMass + masses[i]) / (a * a * a));
+            velocity = (-sinE * p + cosE * q) * (meanMotion / (1.0 - e * cosE));
+        }
+        // Parents were added first and are still in order
+        if (parent >= 0) {
+            position += system.position[parent];
+            velocity += system.velocity[parent];
+        }
+        system.add(position, velocity, masses[i]);
+    }
+    moveToCenterOfMassFrame(system);
+    return system;
+}
+
+// Plummer sphere with G = M = a = 1 (Aarseth, Henon and Wielen 1974),
+// radii beyond 10 are redrawn
+static NBodySystem plummerSphere(size_t count, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    auto direction = [&]() {
+        double z = 2.0 * uniform(random) - 1.0;
+        double phi = 2.0 * glm::pi<double>() * uniform(random);
+        double r = std::sqrt(1.0 - z * z);
+        return glm::dvec3(r * std::cos(phi), r * std::sin(phi), z);
+    };
+    NBodySystem system;
+    for (size_t i = 0; i < count; ++i) {
+        double radius;
+        do {
+            radius = 1.0 / std::sqrt(std::pow(std::max(uniform(random), 1e-12), -2.0 / 3.0) - 1.0);
+        } while (radius > 10.0);
+        // Speed as a fraction q of the escape speed, rejection sampled
+        // from q^2 (1 - q^2)^3.5
+        double q, g;
+        do {
+            q = uniform(random);
+            g = 0.1 * uniform(random);
+        } while (g > q * q * std::pow(1.0 - q * q, 3.5));
+        double speed = q * std::sqrt(2.0) * std::pow(1.0 + radius * radius, -0.25);
+        system.add(direction() * radius, direction() * speed, 1.0 / count);
+    }
+    moveToCenterOfMassFrame(system);
+    return system;
+}
+
+static double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples.empty() ? 0.0 : samples[samples.size() / 2];
+}
+
+void benchmarkNBody(const std::vector<size_t>& bodyCounts, int threadCount) {
+    TaskScheduler scheduler(threadCount);
+    std::cout << "{\n  \"nbody\": {\n    \"threads\": " << scheduler.threadCount()
+        << ",\n    \"theta\": 0.5,\n    \"runs\": [\n";
+    for (size_t n = 0; n < bodyCounts.size(); ++n) {
+        size_t count = bodyCounts[n];
+        NBodySystem system = plummerSphere(count, 1234);
+        system.theta = 0.5;
+        // Softening that minimizes the force error for a Plummer sphere of
+        // this size (Athanassoula et al. 2000), and a step well below the
+        // time to cross it
+        system.softening = 0.98 * std::pow((double)count, -0.26);
+        const double dt = 0.2 * system.softening;
+        // About the same total work per size, at least three steps
+        int steps = (int)std::min<size_t>(200, std::max<size_t>(3, 2000000 / count));
+
+        computeForces(system, scheduler);
+        double startEnergy = totalEnergy(system);
+
+        // Force accuracy against direct summation on a sample of bodies
+        double errorSum = 0.0;
+        const size_t samples = std::min<size_t>(count, 64);
+        for (size_t s = 0; s < samples; ++s) {
+            size_t i = s * count / samples;
+            glm::dvec3 exact(0.0);
+            for (size_t j = 0; j < count; ++j) {
+                if (j == i)
+                    continue;
+                glm::dvec3 d = system.position[j] - system.position[i];
+                double inverse = 1.0 / std::sqrt(glm::dot(d, d) + system.softening * system.softening);
+                exact += d * (system.mass[j] * inverse * inverse * inverse);
+            }
+            double error = glm::length(system.acceleration[i] - exact) / std::max(glm::length(exact), 1e-30);
+            errorSum += error * error;
+        }
+
+        size_t stealsBefore = scheduler.stealCount();
+        std::vector<double> sortMs, buildMs, forceMs, integrateMs, stepMs;
+        for (int step = 0; step < steps; ++step) {
+            NBodyTimings timings;
+            Clock::time_point start = Clock::now();
+            stepNBody(system, dt, scheduler, &timings);
+            stepMs.push_back(millisecondsSince(start));
+            sortMs.push_back(timings.sortMs);
+            buildMs.push_back(timings.buildMs);
+            forceMs.push_back(timings.forceMs);
+            integrateMs.push_back(timings.integrateMs);
+        }
+        double endEnergy = totalEnergy(system);
+
+        std::cout << "      { \"bodies\": " << count
+            << ", \"steps\": " << steps
+            << ", \"dt\": " << dt
+            << ", \"softening\": " << system.softening
+            << ", \"sort_ms\": " << median(sortMs)
+            << ", \"build_ms\": " << median(buildMs)
+            << ", \"force_ms\": " << median(forceMs)
+            << ", \"integrate_ms\": " << median(integrateMs)
+            << ", \"step_ms\": " << median(stepMs)
+            << ", \"ns_per_body_step\": " << median(stepMs) * 1e6 / count
+            << ", \"tree_nodes\": " << system.nodes.size()
+            << ", \"interactions_per_body\": " << system.interactionsPerBody
+            << ", \"steals\": " << scheduler.stealCount() - stealsBefore
+            << ", \"force_rms_error\": " << std::sqrt(errorSum / samples)
+            << ", \"energy_drift\": " << energyDrift(startEnergy, endEnergy) << " }"
+            << (n + 1 < bodyCounts.size() ? ",\n" : "\n");
+    }
+    std::cout << "    ]\n  }\n}\n";
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "OrbitSimulation.h"
+#include "TaskScheduler.h"
+
+// Gravitational N-body simulation with a Barnes-Hut octree.
+//
+// Every force evaluation sorts the bodies along a Morton (z-order) curve
+// and reorders the arrays with them, so each octree cell is one contiguous
+// run of bodies and neighbouring bodies share cache lines and most of
+// their tree walk. The tree is then built top-down over the sorted codes,
+// and the forces are evaluated per body in parallel on the TaskScheduler.
+// A cell is taken as a point mass when its size is below theta times its
+// distance and the body is outside of it; forces are Plummer-softened.
+//
+// Integration is kick-drift-kick leapfrog: symplectic and time reversible,
+// so the energy error oscillates instead of drifting for a fixed step.
+
+struct OctreeNode {
+    glm::dvec3 centerOfMass;
+    double mass;
+    glm::dvec3 center;  // geometric center of the cell
+    double size;        // edge length of the cell
+    int firstChild;     // children are consecutive nodes, -1 for leaves
+    int childCount;
+    int firstBody;      // bodies of the cell are consecutive too
+    int bodyCount;
+};
+
+struct NBodySystem {
+    std::vector<glm::dvec3> position;
+    std::vector<glm::dvec3> velocity;
+    std::vector<glm::dvec3> acceleration;
+    std::vector<double> mass;
+    std::vector<double> potential;  // per unit mass, from the last force evaluation
+    std::vector<int> id;            // index the body was added with, they get reordered
+
+    double gravitationalConstant = 1.0;
+    double theta = 0.5;             // opening angle, smaller is more exact
+    double softening = 1e-3;
+    double time = 0.0;
+
+    // Rebuilt by every force evaluation
+    std::vector<OctreeNode> nodes;
+    std::vector<unsigned long long> mortonCodes;
+    double interactionsPerBody = 0.0;
+
+    size_t size() const { return position.size(); }
+    void add(const glm::dvec3& bodyPosition, const glm::dvec3& bodyVelocity, double bodyMass);
+};
+
+// Millisecond breakdown of one step
+struct NBodyTimings {
+    double sortMs = 0.0;
+    double buildMs = 0.0;
+    double forceMs = 0.0;
+    double integrateMs = 0.0;
+};
+
+// Sorts, builds the octree and fills acceleration and potential. Has to be
+// called once before the first step.
+void computeForces(NBodySystem& system, TaskScheduler& scheduler, NBodyTimings* timings = nullptr);
+// One kick-drift-kick step of dt seconds
+void stepNBody(NBodySystem& system, double dt, TaskScheduler& scheduler, NBodyTimings* timings = nullptr);
+
+// Kinetic plus potential energy, the potential from the last force
+// evaluation (so it carries the same tree approximation as the forces)
+double totalEnergy(const NBodySystem& system);
+// Energy change relative to the start, or absolute when the start is 0
+// (a scene without masses), so it is always a finite number
+double energyDrift(double startEnergy, double endEnergy);
+// Removes the net momentum so the system stays where it is
+void moveToCenterOfMassFrame(NBodySystem& system);
+
+// Bodies of an OrbitState at the given time, moving as they do there but
+// at the speed gravity asks for: each one gets the Kepler velocity of its
+// orbit around its parent's mass instead of the orbit's scripted speed
+NBodySystem createNBodySystem(const OrbitState& orbits, const std::vector<double>& masses,
+    double gravitationalConstant, double time);
+
+// Runs Plummer spheres of each size for a few steps on threadCount threads
+// and prints timings, tree statistics and energy drift as JSON
+void benchmarkNBody(const std::vector<size_t>& bodyCounts, int threadCount);
@@ -0,0 +1,437 @@
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "OrbitSimulation.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ORBIT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+void OrbitState::add(const OrbitElements& elements, float bodyScale, int parentIndex) {
+    // Periapsis direction and the in-plane direction 90 degrees ahead, with
+    // the usual z-up formulas mapped to y-up: (x, y, z) -> (x, z, y)
+    float cosNode = std::cos(elements.ascendingNode), sinNode = std::sin(elements.ascendingNode);
+    float cosPeriapsis = std::cos(elements.argumentOfPeriapsis), sinPeriapsis = std::sin(elements.argumentOfPeriapsis);
+    float cosInclination = std::cos(elements.inclination), sinInclination = std::sin(elements.inclination);
+    float a = elements.semiMajorAxis;
+    float b = a * std::sqrt(1.0f - elements.eccentricity * elements.eccentricity);
+
+    meanAnomaly.push_back(elements.meanAnomaly);
+    meanMotion.push_back(elements.meanMotion);
+    eccentricity.push_back(elements.eccentricity);
+    px.push_back(a * (cosNode * cosPeriapsis - sinNode * sinPeriapsis * cosInclination));
+    py.push_back(a * sinPeriapsis * sinInclination);
+    pz.push_back(a * (sinNode * cosPeriapsis + cosNode * sinPeriapsis * cosInclination));
+    qx.push_back(b * (-cosNode * sinPeriapsis - sinNode * cosPeriapsis * cosInclination));
+    qy.push_back(b * cosPeriapsis * sinInclination);
+    qz.push_back(b * (-sinNode * sinPeriapsis + cosNode * cosPeriapsis * cosInclination));
+    scale.push_back(bodyScale);
+    parent.push_back(parentIndex);
+    bodyRadius.push_back(0.5f * bodyScale);
+    maxEccentricity = std::max(maxEccentricity, elements.eccentricity);
+}
+
+void OrbitState::computeBounds() {
+    const int count = (int)size();
+    subtreeRadius = bodyRadius;
+    firstChild.assign(count, -1);
+    nextSibling.assign(count, -1);
+    roots.clear();
+    // Backwards, so every body is final before its parent is reached and
+    // the satellite lists come out in index order
+    for (int i = count - 1; i >= 0; --i) {
+        int p = parent[i];
+        if (p < 0) {
+            roots.push_back(i);
+            continue;
+        }
+        nextSibling[i] = firstChild[p];
+        firstChild[p] = i;
+        float apoapsis = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]) * (1.0f + eccentricity[i]);
+        subtreeRadius[p] = std::max(subtreeRadius[p], apoapsis + subtreeRadius[i]);
+    }
+    std::reverse(roots.begin(), roots.end());
+}
+
+OrbitState createOrbitState(const Scene& scene) {
+    // Same order as the scene: parents before their children
+    OrbitState state;
+    for (const SceneBody& body : scene.bodies) {
+        OrbitElements elements;
+        elements.semiMajorAxis = body.orbitRadius;
+        elements.eccentricity = body.eccentricity;
+        elements.inclination = body.inclination;
+        elements.ascendingNode = body.ascendingNode;
+        elements.argumentOfPeriapsis = body.argumentOfPeriapsis;
+        elements.meanAnomaly = body.orbitAngle;
+        elements.meanMotion = body.orbitSpeed;
+        state.add(elements, body.scale, body.parent);
+    }
+    // A ring is culled together with its body
+    for (const SceneRing& ring : scene.rings)
+        state.bodyRadius[ring.body] = std::max(state.bodyRadius[ring.body], ring.radius + ring.width / 2.0f);
+    state.computeBounds();
+    return state;
+}
+
+double solveKepler(double meanAnomaly, double eccentricity) {
+    const double pi = glm::pi<double>();
+    double m = meanAnomaly - 2.0 * pi * std::floor(meanAnomaly / (2.0 * pi) + 0.5);
+    // Starting at pi for very eccentric orbits avoids Newton overshooting
+    double e = eccentricity < 0.8 ? m : (m < 0.0 ? -pi : pi);
+    for (int i = 0; i < 50; ++i) {
+        double step = (e - eccentricity * std::sin(e) - m) / (1.0 - eccentricity * std::cos(e));
+        e -= step;
+        if (std::abs(step) < 1e-14)
+            break;
+    }
+    return e;
+}
+
+glm::vec3 orbitPosition(const OrbitState& state, size_t body, double time) {
+    double e = solveKepler(state.meanAnomaly[body] + state.meanMotion[body] * time, state.eccentricity[body]);
+    double u = std::cos(e) - state.eccentricity[body];
+    double v = std::sin(e);
+    return glm::vec3(
+        (float)(u * state.px[body] + v * state.qx[body]),
+        (float)(u * state.py[body] + v * state.qy[body]),
+        (float)(u * state.pz[body] + v * state.qz[body]));
+}
+
+glm::mat4 orbitMatrix(const OrbitState& state, size_t body) {
+    glm::vec3 p(state.px[body], state.py[body], state.pz[body]);
+    glm::vec3 q(state.qx[body], state.qy[body], state.qz[body]);
+    // The ellipse's center sits a * e behind the focus, away from periapsis
+    glm::mat4 matrix(1.0f);
+    matrix[0] = glm::vec4(p, 0.0f);
+    matrix[1] = glm::vec4(glm::normalize(glm::cross(q, p)), 0.0f);
+    matrix[2] = glm::vec4(q, 0.0f);
+    matrix[3] = glm::vec4(-state.eccentricity[body] * p, 1.0f);
+    return matrix;
+}
+
+// translate(x, y, z) * scale(s); its inverse transpose is simply 1 / s
+static inline void writeTransform(PlanetInstance& instance, float x, float y, float z, float s) {
+    float* m = &instance.model[0][0];
+    m[0] = s;    m[1] = 0.0f; m[2] = 0.0f;  m[3] = 0.0f;
+    m[4] = 0.0f; m[5] = s;    m[6] = 0.0f;  m[7] = 0.0f;
+    m[8] = 0.0f; m[9] = 0.0f; m[10] = s;    m[11] = 0.0f;
+    m[12] = x;   m[13] = y;   m[14] = z;    m[15] = 1.0f;
+    float inverse = 1.0f / s;
+    float* n = &instance.normalMatrix[0][0];
+    n[0] = inverse; n[1] = 0.0f;    n[2] = 0.0f;
+    n[3] = 0.0f;    n[4] = inverse; n[5] = 0.0f;
+    n[6] = 0.0f;    n[7] = 0.0f;    n[8] = inverse;
+}
+
+void updateOrbitsScalar(const OrbitState& state, double time, PlanetInstance* instances) {
+    for (size_t i = 0; i < state.size(); ++i) {
+        glm::vec3 position = orbitPosition(state, i, time);
+        writeTransform(instances[i], position.x, position.y, position.z, state.scale[i]);
+    }
+}
+
+#ifdef ORBIT_SSE2
+// floor for SSE2, which has no rounding instruction
+static inline __m128 floor4(__m128 x) {
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+}
+
+// Sine and cosine of four angles at once (Cephes single precision
+// polynomials). The angle is reduced to [-pi/4, pi/4] around the nearest
+// multiple of pi/2, whose quadrant then swaps and negates the results.
+static inline void sincos4(__m128 x, __m128& sinOut, __m128& cosOut) {
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(2.0f / glm::pi<float>())));
+    __m128 q = _mm_cvtepi32_ps(quadrant);
+    // pi/2 split in three parts so the reduction stays exact
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(7.54978995489188216e-8f)));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, r2), r2);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    // Odd quadrants swap sine and cosine
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinValue = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 cosValue = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    // Sine is negative in quadrants 2 and 3, cosine in 1 and 2
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    sinOut = _mm_xor_ps(sinValue, sinSign);
+    cosOut = _mm_xor_ps(cosValue, cosSign);
+}
+
+// Mean anomalies of two bodies at the given time, reduced to [-pi, pi] while
+// still in double precision so large times lose nothing
+static inline __m128d meanAnomaly2(__m128d meanAnomaly, __m128d meanMotion, __m128d time) {
+    // Adding and subtracting 1.5 * 2^52 rounds to the nearest integer
+    const __m128d magic = _mm_set1_pd(6755399441055744.0);
+    __m128d m = _mm_add_pd(meanAnomaly, _mm_mul_pd(meanMotion, time));
+    __m128d turns = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(m, _mm_set1_pd(0.5 / glm::pi<double>())), magic), magic);
+    return _mm_sub_pd(m, _mm_mul_pd(turns, _mm_set1_pd(2.0 * glm::pi<double>())));
+}
+
+// Four bodies' worth of elements in registers
+struct OrbitLanes {
+    __m128 meanAnomaly;
+    __m128 eccentricity;
+    __m128 px, py, pz;
+    __m128 qx, qy, qz;
+};
+
+static inline OrbitLanes loadLanes(const OrbitState& state, size_t i, __m128d time) {
+    OrbitLanes lanes;
+    __m128d low = meanAnomaly2(_mm_loadu_pd(&state.meanAnomaly[i]), _mm_loadu_pd(&state.meanMotion[i]), time);
+    __m128d high = meanAnomaly2(_mm_loadu_pd(&state.meanAnomaly[i + 2]), _mm_loadu_pd(&state.meanMotion[i + 2]), time);
+    lanes.meanAnomaly = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+    lanes.eccentricity = _mm_loadu_ps(&state.eccentricity[i]);
+    lanes.px = _mm_loadu_ps(&state.px[i]);
+    lanes.py = _mm_loadu_ps(&state.py[i]);
+    lanes.pz = _mm_loadu_ps(&state.pz[i]);
+    lanes.qx = _mm_loadu_ps(&state.qx[i]);
+    lanes.qy = _mm_loadu_ps(&state.qy[i]);
+    lanes.qz = _mm_loadu_ps(&state.qz[i]);
+    return lanes;
+}
+
+// SSE2 has no gather, the lanes are assembled from scalar loads
+static inline __m128 gather4(const std::vector<float>& values, const int* bodies) {
+    return _mm_set_ps(values[bodies[3]], values[bodies[2]], values[bodies[1]], values[bodies[0]]);
+}
+
+static inline OrbitLanes gatherLanes(const OrbitState& state, const int* bodies, __m128d time) {
+    OrbitLanes lanes;
+    const std::vector<double>& m = state.meanAnomaly;
+    const std::vector<double>& n = state.meanMotion;
+    __m128d low = meanAnomaly2(_mm_set_pd(m[bodies[1]], m[bodies[0]]), _mm_set_pd(n[bodies[1]], n[bodies[0]]), time);
+    __m128d high = meanAnomaly2(_mm_set_pd(m[bodies[3]], m[bodies[2]]), _mm_set_pd(n[bodies[3]], n[bodies[2]]), time);
+    lanes.meanAnomaly = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+    lanes.eccentricity = gather4(state.eccentricity, bodies);
+    lanes.px = gather4(state.px, bodies);
+    lanes.py = gather4(state.py, bodies);
+    lanes.pz = gather4(state.pz, bodies);
+    lanes.qx = gather4(state.qx, bodies);
+    lanes.qy = gather4(state.qy, bodies);
+    lanes.qz = gather4(state.qz, bodies);
+    return lanes;
+}
+
+// Halley steps needed from Danby's starting guess to reach float precision
+// everywhere on [-pi, pi], measured for each eccentricity range
+static int keplerIterations(float maxEccentricity) {
+    if (maxEccentricity <= 0.0f)
+        return 0;
+    if (maxEccentricity <= 0.5f)
+        return 2;
+    return maxEccentricity <= 0.95f ? 3 : 4;
+}
+
+// Solves Kepler's equation for four bodies with a fixed number of Halley
+// steps (no per-lane branches) and writes their parent-relative positions
+static inline void keplerPositions4(const OrbitLanes& lanes, int iterations, float* x, float* y, float* z) {
+    const __m128 m = lanes.meanAnomaly;
+    const __m128 e = lanes.eccentricity;
+    const __m128 one = _mm_set1_ps(1.0f);
+    // E0 = M + 0.85 e sign(M)
+    __m128 sign = _mm_and_ps(m, _mm_set1_ps(-0.0f));
+    __m128 anomaly = _mm_add_ps(m, _mm_or_ps(_mm_mul_ps(_mm_set1_ps(0.85f), e), sign));
+    __m128 sinE, cosE;
+    for (int i = 0; i < iterations; ++i) {
+        sincos4(anomaly, sinE, cosE);
+        __m128 esin = _mm_mul_ps(e, sinE);
+        __m128 f = _mm_sub_ps(_mm_sub_ps(anomaly, esin), m);
+        __m128 f1 = _mm_sub_ps(one, _mm_mul_ps(e, cosE));
+        // E -= f f' / (f'^2 - f f'' / 2), with f'' = e sin E
+        __m128 denominator = _mm_sub_ps(_mm_mul_ps(f1, f1), _mm_mul_ps(_mm_mul_ps(f, esin), _mm_set1_ps(0.5f)));
+        anomaly = _mm_sub_ps(anomaly, _mm_div_ps(_mm_mul_ps(f, f1), denominator));
+    }
+    sincos4(anomaly, sinE, cosE);
+    __m128 u = _mm_sub_ps(cosE, e);
+    _mm_store_ps(x, _mm_add_ps(_mm_mul_ps(u, lanes.px), _mm_mul_ps(sinE, lanes.qx)));
+    _mm_store_ps(y, _mm_add_ps(_mm_mul_ps(u, lanes.py), _mm_mul_ps(sinE, lanes.qy)));
+    _mm_store_ps(z, _mm_add_ps(_mm_mul_ps(u, lanes.pz), _mm_mul_ps(sinE, lanes.qz)));
+}
+#endif
+
+void updateOrbits(const OrbitState& state, double time, PlanetInstance* instances) {
+#ifdef ORBIT_SSE2
+    const size_t count = state.size();
+    const size_t vectorCount = count & ~(size_t)3;
+    const __m128d t = _mm_set1_pd(time);
+    const int iterations = keplerIterations(state.maxEccentricity);
+    alignas(16) float x[4], y[4], z[4];
+
+    for (size_t i = 0; i < vectorCount; i += 4) {
+        keplerPositions4(loadLanes(state, i, t), iterations, x, y, z);
+        for (int lane = 0; lane < 4; ++lane)
+            writeTransform(instances[i + lane], x[lane], y[lane], z[lane], state.scale[i + lane]);
+    }
+
+    // Remaining bodies through the gather path, padded with the last one
+    if (vectorCount < count) {
+        int bodies[4];
+        for (int lane = 0; lane < 4; ++lane)
+            bodies[lane] = (int)std::min(vectorCount + lane, count - 1);
+        keplerPositions4(gatherLanes(state, bodies, t), iterations, x, y, z);
+        for (size_t i = vectorCount; i < count; ++i)
+            writeTransform(instances[i], x[i - vectorCount], y[i - vectorCount], z[i - vectorCount], state.scale[i]);
+    }
+#else
+    updateOrbitsScalar(state, time, instances);
+#endif
+}
+
+void updateOrbits(const OrbitState& state, double time, const int* bodies, size_t count, PlanetInstance* instances) {
+#ifdef ORBIT_SSE2
+    const __m128d t = _mm_set1_pd(time);
+    const int iterations = keplerIterations(state.maxEccentricity);
+    alignas(16) float x[4], y[4], z[4];
+
+    for (size_t i = 0; i < count; i += 4) {
+        int lanes = (int)std::min<size_t>(4, count - i);
+        int padded[4];
+        for (int lane = 0; lane < 4; ++lane)
+            padded[lane] = bodies[i + std::min(lane, lanes - 1)];
+        keplerPositions4(gatherLanes(state, padded, t), iterations, x, y, z);
+        for (int lane = 0; lane < lanes; ++lane)
+            writeTransform(instances[padded[lane]], x[lane], y[lane], z[lane], state.scale[padded[lane]]);
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 position = orbitPosition(state, bodies[i], time);
+        writeTransform(instances[bodies[i]], position.x, position.y, position.z, state.scale[bodies[i]]);
+    }
+#endif
+}
+
+void applyHierarchy(const OrbitState& state, PlanetInstance* instances) {
+    const int* parents = state.parent.data();
+    for (size_t i = 0; i < state.size(); ++i) {
+        if (parents[i] < 0)
+            continue;
+        const glm::vec4& origin = instances[parents[i]].model[3];
+        glm::vec4& position = instances[i].model[3];
+        position.x += origin.x;
+        position.y += origin.y;
+        position.z += origin.z;
+    }
+}
+
+size_t updateVisibleOrbits(const OrbitState& state, double time, const Frustum& frustum,
+    PlanetInstance* instances, std::vector<unsigned char>& evaluated) {
+    evaluated.assign(state.size(), 0);
+    std::vector<int> level(state.roots), next;
+    size_t count = 0;
+    while (!level.empty()) {
+        updateOrbits(state, time, level.data(), level.size(), instances);
+        next.clear();
+        for (int body : level) {
+            glm::vec4& position = instances[body].model[3];
+            int p = state.parent[body];
+            if (p >= 0) {
+                const glm::vec4& origin = instances[p].model[3];
+                position.x += origin.x;
+                position.y += origin.y;
+                position.z += origin.z;
+            }
+            evaluated[body] = 1;
+            // Satellites of a body whose whole system is off screen are
+            // never evaluated
+            if (!sphereInFrustum(frustum, glm::vec3(position), state.subtreeRadius[body]))
+                continue;
+            for (int child = state.firstChild[body]; child >= 0; child = state.nextSibling[child])
+                next.push_back(child);
+        }
+        count += level.size();
+        level.swap(next);
+    }
+    return count;
+}
+
+static OrbitState randomOrbits(size_t count) {
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> axis(1.0f, 100.0f);
+    std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> eccentricity(0.0f, 0.9f);
+    std::uniform_real_distribution<float> angle(0.0f, 2.0f * glm::pi<float>());
+    std::uniform_real_distribution<float> scale(0.1f, 2.0f);
+    OrbitState state;
+    for (size_t i = 0; i < count; ++i) {
+        OrbitElements elements;
+        elements.semiMajorAxis = axis(random);
+        elements.eccentricity = eccentricity(random);
+        elements.inclination = angle(random) / 24.0f;
+        elements.ascendingNode = angle(random);
+        elements.argumentOfPeriapsis = angle(random);
+        elements.meanAnomaly = angle(random);
+        elements.meanMotion = speed(random);
+        state.add(elements, scale(random));
+    }
+    state.computeBounds();
+    return state;
+}
+
+// Median milliseconds of one update over enough runs for about 10M bodies,
+// each run at a different time
+template <typename Kernel>
+static double timeKernel(Kernel kernel, const OrbitState& state, std::vector<PlanetInstance>& instances) {
+    int runs = (int)std::max<size_t>(5, 10000000 / state.size());
+    std::vector<double> samples;
+    kernel(state, 0.0, instances.data());
+    for (int run = 0; run < runs; ++run) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        kernel(state, run / 60.0, instances.data());
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+void benchmarkOrbitUpdate(const std::vector<size_t>& bodyCounts) {
+    auto simdKernel = [](const OrbitState& state, double time, PlanetInstance* instances) {
+        updateOrbits(state, time, instances);
+    };
+    std::cout << "{\n  \"orbit_update\": [\n";
+    for (size_t n = 0; n < bodyCounts.size(); ++n) {
+        size_t count = bodyCounts[n];
+        OrbitState state = randomOrbits(count);
+        std::vector<PlanetInstance> scalarInstances(count), simdInstances(count);
+
+        // Compare both kernels after a jump a million seconds ahead,
+        // relative to each orbit's size
+        const double jump = 1e6;
+        updateOrbitsScalar(state, jump, scalarInstances.data());
+        updateOrbits(state, jump, simdInstances.data());
+        float maxError = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 delta = glm::vec3(scalarInstances[i].model[3]) - glm::vec3(simdInstances[i].model[3]);
+            float axis = glm::length(glm::vec3(state.px[i], state.py[i], state.pz[i]));
+            maxError = std::max(maxError, glm::length(delta) / axis);
+        }
+
+        double scalarMs = timeKernel(updateOrbitsScalar, state, scalarInstances);
+        double simdMs = timeKernel(simdKernel, state, simdInstances);
+        std::cout << "    { \"bodies\": " << count
+            << ", \"max_eccentricity\": " << state.maxEccentricity
+            << ", \"scalar_ms\": " << scalarMs
+            << ", \"simd_ms\": " << simdMs
+            << ", \"simd_ns_per_body\": " << simdMs * 1e6 / count
+            << ", \"speedup\": " << scalarMs / simdMs
+            << ", \"max_relative_error\": " << maxError << " }"
+            << (n + 1 < bodyCounts.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}\n";
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "Frustum.h"
+#include "Scene.h"
+
+// Per-instance data of the instanced planet shader (attributes 3-10)
+struct PlanetInstance {
+    glm::mat4 model;
+    float layer;     // layer in the planet texture array
+    float emissive;  // 1 = unlit (the Sun)
+    glm::mat3 normalMatrix;
+};
+
+// Keplerian elements of an elliptic orbit around the parent. The reference
+// plane is xz with +y up; a circular orbit with all angles 0 starts on +x
+// and moves towards +z.
+struct OrbitElements {
+    float semiMajorAxis = 0.0f;
+    float eccentricity = 0.0f;         // 0 = circle, at most MAX_ECCENTRICITY (Scene.h)
+    float inclination = 0.0f;          // radians, tilt out of the xz plane
+    float ascendingNode = 0.0f;        // radians, from +x towards +z
+    float argumentOfPeriapsis = 0.0f;  // radians, from the ascending node
+    double meanAnomaly = 0.0;          // radians at time 0
+    double meanMotion = 0.0;           // radians per second
+};
+
+// Closed-form orbits stored as structure of arrays. Positions are a pure
+// function of the time, nothing is integrated: any time can be evaluated
+// directly, in any order and for any subset of the bodies. Bodies are
+// topologically ordered: parent[i] < i, or -1 for orbits around the origin.
+struct OrbitState {
+    // Doubles, so mean anomalies stay exact for large times
+    std::vector<double> meanAnomaly;
+    std::vector<double> meanMotion;
+    std::vector<float> eccentricity;
+    // Orbit plane axes: periapsis direction * a and the direction 90
+    // degrees further along the orbit * b
+    std::vector<float> px, py, pz;
+    std::vector<float> qx, qy, qz;
+    std::vector<float> scale;   // uniform scale of the body's unit sphere
+    std::vector<int> parent;
+
+    // Culling bounds, filled by computeBounds
+    std::vector<float> bodyRadius;     // the body and anything drawn with it
+    std::vector<float> subtreeRadius;  // the body and all its satellites, around the body
+    std::vector<int> firstChild;       // satellite lists, -1 terminated
+    std::vector<int> nextSibling;
+    std::vector<int> roots;
+    float maxEccentricity = 0.0f;
+
+    size_t size() const { return meanAnomaly.size(); }
+    void add(const OrbitElements& elements, float bodyScale, int parentIndex = -1);
+    // Call after the last add and after raising any bodyRadius
+    void computeBounds();
+};
+
+// Orbits of the scene's bodies in scene order, with their rings counted
+// into the culling bounds
+OrbitState createOrbitState(const Scene& scene);
+
+// Solves Kepler's equation M = E - e sin E in double precision (Newton to
+// convergence), the reference the vector kernel is measured against
+double solveKepler(double meanAnomaly, double eccentricity);
+// Position of one body relative to its parent at the given time
+glm::vec3 orbitPosition(const OrbitState& state, size_t body, double time);
+// Maps the unit circle in the xz plane onto the body's orbit ellipse,
+// relative to the parent
+glm::mat4 orbitMatrix(const OrbitState& state, size_t body);
+
+// Writes each body's model and normal matrix at the given time, relative to
+// its parent, into instances[i] (layer and emissive are left alone). Solves
+// Kepler's equation with SSE2 four bodies at a time where available.
+void updateOrbits(const OrbitState& state, double time, PlanetInstance* instances);
+// Reference version in double precision, one body at a time
+void updateOrbitsScalar(const OrbitState& state, double time, PlanetInstance* instances);
+// Same as updateOrbits for the listed bodies only
+void updateOrbits(const OrbitState& state, double time, const int* bodies, size_t count, PlanetInstance* instances);
+
+// Turns the parent-relative transforms into world transforms in one forward
+// sweep: a parent is always final before its children are reached. Only
+// the position is inherited, a moon's size does not follow its planet's.
+void applyHierarchy(const OrbitState& state, PlanetInstance* instances);
+
+// Lazy evaluation for rendering: the roots first, then level by level only
+// the satellites of bodies whose subtree bound intersects the frustum.
+// Writes world transforms, sets evaluated[i] for every body it wrote and
+// leaves the others stale. Returns the number of evaluated bodies.
+size_t updateVisibleOrbits(const OrbitState& state, double time, const Frustum& frustum,
+    PlanetInstance* instances, std::vector<unsigned char>& evaluated);
+
+// Times both kernels for each body count and prints the results as JSON
+void benchmarkOrbitUpdate(const std::vector<size_t>& bodyCounts);
@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "ProgramCache.h"
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+static GetProgramBinaryProc getProgramBinary = nullptr;
+static ProgramBinaryProc programBinary = nullptr;
+static ProgramParameteriProc programParameteri = nullptr;
+static std::string cacheDirectory;
+static std::string driverString;
+static bool cacheEnabled = false;
+
+static const uint32_t CACHE_MAGIC = 0x31434250;  // "PBC1"
+
+bool initProgramBinaryCache(GLADloadproc loadProc, const char* directory) {
+    getProgramBinary = (GetProgramBinaryProc)loadProc("glGetProgramBinary");
+    programBinary = (ProgramBinaryProc)loadProc("glProgramBinary");
+    programParameteri = (ProgramParameteriProc)loadProc("glProgramParameteri");
+    if (!getProgramBinary || !programBinary || !programParameteri)
+        return false;
+
+    // Drivers may export the functions yet offer no binary format at all;
+    // on contexts without the feature the query fails and leaves 0
+    int formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    while (glGetError() != GL_NO_ERROR) {}
+    if (formats <= 0)
+        return false;
+
+    driverString = std::string((const char*)glGetString(GL_VENDOR)) + "\n"
+        + (const char*)glGetString(GL_RENDERER) + "\n"
+        + (const char*)glGetString(GL_VERSION);
+    cacheDirectory = directory;
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    cacheEnabled = true;
+    return true;
+}
+
+// FNV-1a, 64 bit
+static uint64_t hashString(uint64_t hash, const std::string& text) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
+    }
+    // Separator, so moving text between the parts changes the hash
+    hash ^= 0xFF;
+    hash *= 0x100000001B3ull;
+    return hash;
+}
+
+static std::string cachePath(const std::string& vertexCode, const std::string& fragmentCode) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = hashString(hash, vertexCode);
+    hash = hashString(hash, fragmentCode);
+    hash = hashString(hash, driverString);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return cacheDirectory + "/" + name;
+}
+
+unsigned int loadCachedProgram(const std::string& vertexCode, const std::string& fragmentCode) {
+    if (!cacheEnabled)
+        return 0;
+
+    std::string path = cachePath(vertexCode, fragmentCode);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return 0;
+    uint32_t magic = 0, format = 0, length = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+    if (!file || magic != CACHE_MAGIC)
+        return 0;
+    // A corrupt length must not size the allocation, the binary has to fit
+    // in what is left of the file; otherwise the entry is dropped and the
+    // program compiled and stored again
+    std::streamoff header = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - header;
+    file.seekg(header);
+    if (!file || remaining < 0 || (uint64_t)length > (uint64_t)remaining) {
+        file.close();
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return 0;
+    }
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if (!file)
+        return 0;
+
+    unsigned int program = glCreateProgram();
+    programBinary(program, format, binary.data(), (GLsizei)length);
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Format or driver changed underneath, compile from source instead
+        glDeleteProgram(program);
+        while (glGetError() != GL_NO_ERROR) {}
+        return 0;
+    }
+    return program;
+}
+
+void prepareCachedProgram(unsigned int program) {
+    if (cacheEnabled)
+        programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void storeCachedProgram(unsigned int program, const std::string& vertexCode, const std::string& fragmentCode) {
+    if (!cacheEnabled)
+        return;
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+
+    // Write to a temporary file first so a crash never leaves a truncated entry
+    std::string path = cachePath(vertexCode, fragmentCode);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        uint32_t format32 = format, length32 = (uint32_t)written;
+        file.write((const char*)&CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        file.write((const char*)&format32, sizeof(format32));
+        file.write((const char*)&length32, sizeof(length32));
+        file.write(binary.data(), written);
+        if (!file) {
+            std::cerr << "WARNING::SHADER::CANNOT_WRITE_CACHE " << path << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+}
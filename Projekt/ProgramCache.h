@@ -0,0 +1,24 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+
+// On-disk cache of linked shader programs (glGetProgramBinary /
+// glProgramBinary, core in GL 4.1 and ARB_get_program_binary). Entries are
+// keyed by a hash of both shader sources and the vendor/renderer/version
+// strings, so editing a shader or updating the driver simply misses the
+// cache; a binary the driver rejects is recompiled and replaced.
+//
+// The glad loader only covers GL 3.3, so the entry points are resolved
+// here with the same proc address function glad was initialized with.
+
+// Enables the cache when the context supports program binaries
+bool initProgramBinaryCache(GLADloadproc loadProc, const char* directory = "shader_cache");
+
+// Returns a linked program from the cache, 0 on a miss
+unsigned int loadCachedProgram(const std::string& vertexCode, const std::string& fragmentCode);
+
+// Call before glLinkProgram so the driver keeps the binary retrievable
+void prepareCachedProgram(unsigned int program);
+
+// Stores a successfully linked program
+void storeCachedProgram(unsigned int program, const std::string& vertexCode, const std::string& fragmentCode);
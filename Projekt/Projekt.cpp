@@ -3,24 +3,79 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <fstream>
-#include <sstream>
+#include <glm/gtc/matrix_inverse.hpp>
 #include <iostream>
 #include <vector>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <chrono>
+#include "Headless.h"
+#include "Bench.h"
+#include "Shader.h"
+#include "UniformBuffers.h"
+#include "Texture.h"
+#include "AssetPack.h"
+#include "ProgramCache.h"
+#include "FileWatcher.h"
+#include "SphereMesh.h"
+#include "Frustum.h"
+#include "NBody.h"
+#include "SimulationThread.h"
+#include "TimeWarp.h"
+#include "OrbitSimulation.h"
+#include "Scene.h"
+#include "Belt.h"
 
 // Function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadShader(const char* vertexPath, const char* fragmentPath);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void updateCameraFront();
 std::vector<float> generateFlatRingVertices(float radius, float ringWidth, int segments);
 std::vector<unsigned int> generateFlatRingIndices(int segments);
-void drawOrbit(float radius, int segments, glm::mat4 view, glm::mat4 projection, unsigned int shaderProgram);
-unsigned int loadTexture(const char* path);
-std::vector<float> generateSphereVertices(float radius, int sectorCount, int stackCount);
+// Per-draw uniform handles of the planet shader, resolved once after linking.
+// Camera, light and material state lives in the Frame/Lighting blocks.
+struct SceneUniforms {
+    Uniform<glm::mat4> model;
+    Uniform<glm::mat3> normalMatrix;
+    Uniform<int> textures;
+    Uniform<float> textureLayer;
+    Uniform<int> isSun;
+};
+SceneUniforms resolveSceneUniforms(const Shader& shader);
+// Sets model and the matching normal matrix
+void setModelMatrix(const SceneUniforms& uniforms, const glm::mat4& model);
+// Uniforms that stay constant for the whole run, set after linking and
+// again whenever hot reload swaps in a new program
+void setSceneShaderConstants(const Shader& shader, const SceneUniforms& uniforms, float orbitLayer);
+void setPlanetShaderConstants(const Shader& planetShader);
+
+struct OrbitGeometry {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    int segments = 0;
+};
+OrbitGeometry createOrbitGeometry(int segments);
+void deleteOrbitGeometry(OrbitGeometry& orbit);
+void drawOrbit(const OrbitGeometry& orbit, const glm::mat4& model, const SceneUniforms& uniforms);
+
+// Flat ring around a body, attribute 0 only
+struct RingMesh {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    int indexCount = 0;
+    unsigned int indexType = 0;
+};
+RingMesh createRingMesh(float radius, float ringWidth, int segments, VertexFormat format);
+void deleteRingMesh(RingMesh& ring);
+// Points the per-instance attributes (3-10) of the bound VAO at the
+// instance buffer, starting at firstInstance
+void setPlanetInstanceAttributes(size_t firstInstance);
 
 
 // Camera settings
@@ -37,129 +92,326 @@ float fov = 45.0f;
 
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
+// Simulated seconds per real second, changed from the keyboard
+TimeWarp timeWarp;
+
+int main(int argc, char** argv) {
+    std::chrono::steady_clock::time_point programStart = std::chrono::steady_clock::now();
+
+    // Command line options
+    // --headless          render offscreen through EGL instead of opening a window
+    // --frames N          number of frames to render in headless/bench mode
+    // --size W H          framebuffer size
+    // --output file.ppm   save the last headless frame
+    // --bench             fixed timestep run reporting per-phase frame timings
+    // --warmup N          frames rendered before bench timings are recorded
+    // --timestep S        simulated seconds per frame in headless/bench mode
+    // --bench-output F    write bench JSON to F instead of stdout
+    // --texture-threads N image decode threads (0 = one per core)
+    // --no-texture-cache  keep textures uncompressed, skip the BC1 .dds cache
+    // --pack file         load textures and shaders from a memory-mapped asset pack
+    // --build-pack file   pack textures/, .dds caches and shaders into file and exit
+    // --no-shader-cache   always compile shaders, skip the program binary cache
+    // --watch-shaders     reload edited .glsl files while running (always on in a window)
+    // --sphere-mesh uv|ico sphere tessellation: icosphere (default) or UV sphere
+    // --sphere-detail N   use one sphere for every body instead of LODs: N subdivisions
+    //                     (ico, at most 7) or N stacks and 2N sectors (uv, at most 512);
+    //                     the vertex stress test is --sphere-mesh uv --sphere-detail 256
+    // --vertex-format packed|float  sphere and ring vertices as 16-bit packed
+    //                     attributes with 16-bit indices (default) or plain floats
+    // --no-frustum-cull   submit every body, ring and orbit even when off screen
+    // --orbit-bench       time the orbit update kernel for 10k-1M bodies and exit
+    // --scene file        scene description to render (default scenes/solar_system.json)
+    // --belt-density F    multiply the body count of every belt by F (0 = no belts)
+    //                     (the default scene has none, scenes/solar_system_belts.json
+    //                     adds 300k belt bodies as a stress test)
+    // --time S            start the simulation S seconds after the scene's epoch
+    // --nbody             move the bodies by their mutual gravity (Barnes-Hut) instead
+    //                     of their scripted orbits; orbit lines are not drawn
+    // --nbody-step S      N-body integration step in seconds (default 1/240)
+    // --nbody-bench       time Barnes-Hut steps for 10-1M bodies and exit
+    // --sim-threads N     N-body worker threads (0 = one per core)
+    // --warp F            start at F simulated seconds per real second (0 = paused,
+    //                     negative runs backwards, up to 1e7 either way)
+    // --warp-bench        time orbit, belt and N-body updates at every warp level and exit
+    // --sim-thread        step the N-body simulation on its own thread in headless/bench
+    //                     mode too (windowed runs always do; fixed-step runs otherwise
+    //                     step it in lockstep with the frames to stay reproducible)
+    bool headless = false;
+    bool bench = false;
+    int frameCount = 100;
+    int warmupFrames = 10;
+    float timestep = 1.0f / 60.0f;
+    int width = 1600;
+    int height = 1200;
+    const char* outputPath = nullptr;
+    const char* benchOutputPath = nullptr;
+    int textureThreads = 0;
+    bool textureCache = true;
+    const char* packPath = nullptr;
+    bool shaderCache = true;
+    bool watchShaders = false;
+    SphereType sphereType = SPHERE_ICO;
+    int sphereDetail = -1;
+    VertexFormat vertexFormat = VERTEX_PACKED;
+    bool frustumCulling = true;
+    const char* scenePath = "scenes/solar_system.json";
+    float beltDensity = 1.0f;
+    double startTime = 0.0;
+    bool nbody = false;
+    bool nbodyBench = false;
+    double nbodyStep = 1.0 / 240.0;
+    int simThreads = 0;
+    bool simThread = false;
+    bool warpBench = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmupFrames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--timestep") == 0 && i + 1 < argc) {
+            timestep = (float)atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-output") == 0 && i + 1 < argc) {
+            benchOutputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--texture-threads") == 0 && i + 1 < argc) {
+            textureThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--no-texture-cache") == 0) {
+            textureCache = false;
+        }
+        else if (strcmp(argv[i], "--sphere-detail") == 0 && i + 1 < argc) {
+            sphereDetail = std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--sphere-mesh") == 0 && i + 1 < argc) {
+            sphereType = strcmp(argv[++i], "uv") == 0 ? SPHERE_UV : SPHERE_ICO;
+        }
+        else if (strcmp(argv[i], "--vertex-format") == 0 && i + 1 < argc) {
+            vertexFormat = strcmp(argv[++i], "float") == 0 ? VERTEX_FLOAT : VERTEX_PACKED;
+        }
+        else if (strcmp(argv[i], "--belt-density") == 0 && i + 1 < argc) {
+            beltDensity = std::max(0.0f, (float)atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--nbody") == 0) {
+            nbody = true;
+        }
+        else if (strcmp(argv[i], "--nbody-step") == 0 && i + 1 < argc) {
+            nbodyStep = std::max(1e-6, atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--nbody-bench") == 0) {
+            nbodyBench = true;
+        }
+        else if (strcmp(argv[i], "--sim-threads") == 0 && i + 1 < argc) {
+            simThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--sim-thread") == 0) {
+            simThread = true;
+        }
+        else if (strcmp(argv[i], "--warp") == 0 && i + 1 < argc) {
+            timeWarp.set(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--warp-bench") == 0) {
+            warpBench = true;
+        }
+        else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            startTime = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            scenePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-frustum-cull") == 0) {
+            frustumCulling = false;
+        }
+        else if (strcmp(argv[i], "--watch-shaders") == 0) {
+            watchShaders = true;
+        }
+        else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            shaderCache = false;
+        }
+        else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--orbit-bench") == 0) {
+            benchmarkOrbitUpdate({ 10000, 100000, 1000000 });
+            return 0;
+        }
+        else if (strcmp(argv[i], "--build-pack") == 0 && i + 1 < argc) {
+            return buildAssetPack(argv[i + 1], defaultAssetFiles()) ? 0 : -1;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frameCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+            width = atoi(argv[++i]);
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
 
-int main() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
+    if (nbodyBench) {
+        benchmarkNBody({ 10, 100, 1000, 10000, 100000, 1000000 }, simThreads);
+        return 0;
     }
 
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (packPath && !mountAssetPack(packPath))
+        std::cerr << "Falling back to loading assets from files" << std::endl;
 
-    // Create a window
-    GLFWwindow* window = glfwCreateWindow(1600, 1200, "Solar System", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+    // Bodies, rings and textures to render
+    Scene scene;
+    if (!loadScene(scenePath, scene))
         return -1;
-    }
-    glfwMakeContextCurrent(window);
 
-    // Load OpenGL functions using GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        return -1;
+    if (warpBench) {
+        benchmarkTimeWarp(scene, simThreads);
+        return 0;
     }
 
-    // Set viewport
-    glViewport(0, 0, 1600, 1200);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // Set input callbacks
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
-    // Capture the mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
 
-    // Build and compile shaders
-    unsigned int shaderProgram = loadShader("vertex_shader.glsl", "fragment_shader.glsl");
-
-    // Define vertices for the planets and the sun (for simplicity, we use a sphere for each)
-    float radius = 0.5f;
-    int sectorCount = 36;
-    int stackCount = 18;
+    if (headless) {
+        // Create a window-less context, rendering goes into an FBO
+        if (!createHeadlessContext(headlessContext)) {
+            std::cerr << "Failed to create headless OpenGL context" << std::endl;
+            return -1;
+        }
 
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    for (int i = 0; i <= stackCount; ++i) {
-        float theta = i * glm::pi<float>() / stackCount;
-        float sinTheta = sin(theta);
-        float cosTheta = cos(theta);
+        if (!gladLoadGLLoader((GLADloadproc)headlessGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            destroyHeadlessContext(headlessContext);
+            return -1;
+        }
 
-        for (int j = 0; j <= sectorCount; ++j) {
-            float phi = j * 2 * glm::pi<float>() / sectorCount;
-            float sinPhi = sin(phi);
-            float cosPhi = cos(phi);
+        if (!createHeadlessFramebuffer(headlessContext, width, height)) {
+            destroyHeadlessContext(headlessContext);
+            return -1;
+        }
+        std::clog << "Headless renderer: " << glGetString(GL_RENDERER) << std::endl;
 
-            float x = cosPhi * sinTheta;
-            float y = cosTheta;
-            float z = sinPhi * sinTheta;
-            float u = (float)j / sectorCount;
-            float v = (float)i / stackCount;
+        glViewport(0, 0, width, height);
 
-            // vertex position
-            vertices.push_back(radius * x);
-            vertices.push_back(radius * y);
-            vertices.push_back(radius * z);
+        // There is no mouse to turn the camera, start from the yaw/pitch view
+        updateCameraFront();
+    }
+    else {
+        // Initialize GLFW
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-            // normal vector
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
+        // Configure GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // Create a window
+        window = glfwCreateWindow(width, height, "Solar System", nullptr, nullptr);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
 
-            // texture coordinates
-            vertices.push_back(u);
-            vertices.push_back(v);
+        // Load OpenGL functions using GLAD
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return -1;
         }
-    }
 
-    // Generate indices
-    for (int i = 0; i < stackCount; ++i) {
-        for (int j = 0; j < sectorCount; ++j) {
-            int first = (i * (sectorCount + 1)) + j;
-            int second = first + sectorCount + 1;
+        // Set viewport
+        glViewport(0, 0, width, height);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+        // Set input callbacks
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetKeyCallback(window, key_callback);
 
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
+        // Capture the mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
+        if (bench) {
+            // Measure the renderer, not the display refresh rate, and always
+            // benchmark the same camera view
+            glfwSwapInterval(0);
+            updateCameraFront();
         }
     }
 
-    // Convert vertices and indices vectors to arrays
-    float* sphereVertices = vertices.data();
-    unsigned int* sphereIndices = indices.data();
-
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), sphereVertices, GL_STATIC_DRAW);
+    // Linked programs are cached on disk after the first run
+    if (shaderCache) {
+        GLADloadproc loadProc = headless ? (GLADloadproc)headlessGetProcAddress : (GLADloadproc)glfwGetProcAddress;
+        if (!initProgramBinaryCache(loadProc))
+            std::clog << "Program binaries not supported, shaders are compiled on every start" << std::endl;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), sphereIndices, GL_STATIC_DRAW);
+    // Build and compile shaders
+    Shader shader;
+    shader.load("vertex_shader.glsl", "fragment_shader.glsl");
+    SceneUniforms uniforms = resolveSceneUniforms(shader);
+
+    // All planets and moons are drawn in one instanced call
+    Shader planetShader;
+    planetShader.load("instanced_vertex_shader.glsl", "instanced_fragment_shader.glsl", vertexFormatDefines(vertexFormat));
+
+    // Belt bodies are placed entirely on the GPU, lit like the planets
+    Shader beltShader;
+    beltShader.load("belt_vertex_shader.glsl", "instanced_fragment_shader.glsl", vertexFormatDefines(vertexFormat));
+    Uniform<float> beltTime = beltShader.uniform<float>("time");
+    Uniform<float> beltLayer = beltShader.uniform<float>("beltLayer");
+
+    // Edited shaders are recompiled in the background and swapped in once
+    // they link, so the textures and the scene stay loaded
+    FileWatcher shaderWatcher;
+    if (!headless && !bench)
+        watchShaders = true;
+    if (watchShaders) {
+        GLADloadproc loadProc = headless ? (GLADloadproc)headlessGetProcAddress : (GLADloadproc)glfwGetProcAddress;
+        initParallelShaderCompile(loadProc);
+        shaderWatcher.start({ "vertex_shader.glsl", "fragment_shader.glsl",
+            "instanced_vertex_shader.glsl", "instanced_fragment_shader.glsl", "belt_vertex_shader.glsl" });
+    }
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // Texture coord attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Sphere meshes from 20 up to 20480 triangles (icosahedron subdivided
+    // 0-5 times, or UV spheres from 8x4 to 256x128 segments); every frame
+    // each body picks the level that matches its size on screen
+    std::vector<int> sphereLevelDetails = { 0, 1, 2, 3, 4, 5 };
+    if (sphereType == SPHERE_UV)
+        sphereLevelDetails = { 4, 8, 16, 32, 64, 128 };
+    if (sphereDetail >= 0)
+        sphereLevelDetails = { sphereDetail };
+    SphereMeshSet sphereMesh = createSphereMeshSet(0.5f, sphereType, sphereLevelDetails, vertexFormat);
+    const size_t sphereLevels = sphereMesh.levels.size();
+
+    // Per-instance attributes, refilled every frame
+    unsigned int instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    setPlanetInstanceAttributes(0);
+
+    // Belts reuse the coarsest sphere level, their instances never change
+    std::vector<Belt> belts;
+    int beltBodies = 0;
+    for (const SceneBelt& sceneBelt : scene.belts) {
+        belts.push_back(createBelt(sceneBelt, sphereMesh, beltDensity));
+        beltBodies += belts.back().count;
+    }
+    if (!belts.empty())
+        std::clog << "Belts: " << beltBodies << " bodies" << std::endl;
 
     // Enable depth testing
     glEnable(GL_DEPTH_TEST);
@@ -167,265 +419,402 @@ int main() {
     // Lighting settings
     glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-    // Define positions for the planets
-    glm::vec3 planetPositions[] = {
-        glm::vec3(0.0f, 0.0f, 0.0f),   // Slonce
-        glm::vec3(8.0f, 0.0f, 0.0f),   // Merkury
-        glm::vec3(11.0f, 0.0f, 0.0f),    // Wenus
-        glm::vec3(15.0f, 0.0f, 0.0f),    // Ziemia
-        glm::vec3(18.0f, 0.0f, 0.0f),    // Mars
-        glm::vec3(25.0f, 0.0f, 0.0f),    // Jowisz
-        glm::vec3(35.0f, 0.0f, 0.0f),    // Saturn
-        glm::vec3(45.0f, 0.0f, 0.0f),    // Uran
-        glm::vec3(53.0f, 0.0f, 0.0f),    // Neptun
-        // Add more planet positions as needed
-    };
-    float size_factor = 0.6f;
-    glm::vec3 planetScales[] = {
-        glm::vec3(10.0f, 10.0f, 10.0f),   // Slonce
-        glm::vec3(size_factor*0.45, size_factor * 0.45, size_factor * 0.45),         // Merkury
-        glm::vec3(size_factor * 0.949, size_factor * 0.949, size_factor * 0.949),    // Wenus
-        glm::vec3(size_factor, size_factor, size_factor),                            // Ziemia
-        glm::vec3(size_factor*0.53, size_factor * 0.53, size_factor * 0.53),         // Mars
-        glm::vec3(size_factor * 11.2,size_factor * 11.2, size_factor * 11.2),         // Jowisz
-        glm::vec3(size_factor * 9.45, size_factor * 9.45, size_factor * 9.45),       // Saturn
-        glm::vec3(size_factor * 4, size_factor * 4, size_factor * 4),                // Uran
-        glm::vec3(size_factor * 3.88, size_factor * 3.88, size_factor * 3.88),       // Neptun
-        // Dodaj więcej współczynników skalowania dla kolejnych planet
-    };
-    float speed_factor = 40.0f;
-    float orbitSpeeds[] = {
-        0.0f,
-        speed_factor*4,   // merkury
-        speed_factor * 1.62,  // wenus
-        speed_factor,  // ziemia
-        speed_factor * 0.53,  // mars
-        speed_factor * 0.084f,  // jowisz
-        speed_factor * 0.033 ,  // saturn
-        speed_factor * 0.012,  // uran
-        speed_factor * 0.006,  // neptun
-    };
-
-    float orbitAngles[] = {
-        0.0f,   // Słońce
-        0.0f,   // Merkury
-        0.0f,   // Wenus
-        0.0f,   // Ziemia
-        0.0f,   // Mars
-        0.0f,   // Jowisz
-        0.0f,   // Saturn
-        0.0f,   // Uran
-        0.0f    // Neptun
-    };
-
-    glm::vec3 planetColors[] = {
-    glm::vec3(1.0f, 1.0f, 0.0f),  // Słońce (żółty)
-    glm::vec3(0.5f, 0.5f, 0.5f),  // Merkury (szary)
-    glm::vec3(1.0f, 0.5f, 0.0f),  // Wenus (pomarańczowy)
-    glm::vec3(0.0f, 0.0f, 1.0f),  // Ziemia (niebieski)
-    glm::vec3(1.0f, 0.0f, 0.0f),  // Mars (czerwony)
-    glm::vec3(1.0f, 1.0f, 1.0f),  // Jowisz (biały)
-    glm::vec3(1.0f, 1.0f, 0.5f),  // Saturn (jasno żółty)
-    glm::vec3(0.5f, 0.5f, 1.0f),  // Uran (jasno niebieski)
-    glm::vec3(0.0f, 0.0f, 0.5f),  // Neptun (ciemno niebieski)
-    // Dodaj więcej kolorów dla innych planet
-    };
-
     glm::vec3 sunColor = glm::vec3(1.0f, 1.0f, 0.0f); // Na przykład żółty
     float glowRadius = 10.0f; // Na przykład promień 2 jednostek
 
-    glm::vec3 moonPosition = glm::vec3(10.0f, 0.0f, 0.0f); // Pozycja Ziemi
-    float moonOrbitRadius = 1.0f; // Promień orbity Księżyca
-    float moonOrbitSpeed = speed_factor * 13.36f; // Szybkość orbity Księżyca
-    float moonOrbitAngle = 0.0f;
-
-    // Inicjalizacja płaskiego pierścienia Saturna
-    std::vector<float> flatRingVertices = generateFlatRingVertices(7.5f * size_factor, 1.7f, 36);
-    std::vector<unsigned int> flatRingIndices = generateFlatRingIndices(36);
-
-    unsigned int flatRingVBO, flatRingVAO, flatRingEBO;
-    glGenVertexArrays(1, &flatRingVAO);
-    glGenBuffers(1, &flatRingVBO);
-    glGenBuffers(1, &flatRingEBO);
-
-    glBindVertexArray(flatRingVAO);
+    // Light and material never change, upload them once
+    LightingBlock lighting;
+    lighting.lightPosition = lightPos;
+    lighting.lightAmbient = glm::vec3(0.2f, 0.2f, 0.2f);
+    lighting.lightDiffuse = glm::vec3(0.5f, 0.5f, 0.5f);
+    lighting.lightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+    lighting.materialSpecular = glm::vec3(0.1f, 0.1f, 0.1f);
+    lighting.materialShininess = 4.0f;
+    lighting.sunColor = sunColor;
+    lighting.glowRadius = glowRadius;
+    unsigned int lightingUBO = createUniformBuffer(LIGHTING_BLOCK_BINDING, sizeof(LightingBlock), &lighting, false);
+
+    // Camera state, rewritten every frame
+    FrameBlock frameData;
+    unsigned int frameUBO = createUniformBuffer(FRAME_BLOCK_BINDING, sizeof(FrameBlock), nullptr, true);
+
+    // One VAO per ring of the scene
+    std::vector<RingMesh> ringMeshes;
+    for (const SceneRing& ring : scene.rings)
+        ringMeshes.push_back(createRingMesh(ring.radius, ring.width, 36, vertexFormat));
+
+    // One unit circle shared by all orbits, mapped onto each orbit's ellipse when drawn
+    OrbitGeometry orbitGeometry = createOrbitGeometry(100);
+
+    // One array layer per distinct texture of the scene. All draws share
+    // this single texture.
+    std::vector<const char*> planetTexturePaths;
+    for (const std::string& path : scene.textures)
+        planetTexturePaths.push_back(path.c_str());
+    // Decode in the background, the first frames show placeholders.
+    // Headless and bench runs wait so their output never depends on timing.
+    TextureArrayLoader textureLoader;
+    unsigned int planetTextureArray = textureLoader.start(planetTexturePaths, textureThreads, textureCache);
+    if (headless || bench) {
+        textureLoader.finish();
+    }
+    const float orbitLayer = (float)scene.orbitTextureLayer;
 
-    glBindBuffer(GL_ARRAY_BUFFER, flatRingVBO);
-    glBufferData(GL_ARRAY_BUFFER, flatRingVertices.size() * sizeof(float), flatRingVertices.data(), GL_STATIC_DRAW);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, planetTextureArray);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, flatRingEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, flatRingIndices.size() * sizeof(unsigned int), flatRingIndices.data(), GL_STATIC_DRAW);
+    setSceneShaderConstants(shader, uniforms, orbitLayer);
+    setPlanetShaderConstants(planetShader);
+    setPlanetShaderConstants(beltShader);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    OrbitState orbits = createOrbitState(scene);
+    // Orbit ellipses relative to the parent never change
+    std::vector<glm::mat4> orbitMatrices(orbits.size(), glm::mat4(1.0f));
+    for (size_t i = 0; i < scene.bodies.size(); ++i) {
+        if (scene.bodies[i].orbitLine)
+            orbitMatrices[i] = orbitMatrix(orbits, i);
+    }
 
-    unsigned int earthTexture = loadTexture("textures/earth.jpg");
-    unsigned int sunTexture = loadTexture("textures/sun.jpg");
-    unsigned int mercuryTexture = loadTexture("textures/mercury.jpg");
-    unsigned int venusTexture = loadTexture("textures/venus.jpg");
-    unsigned int marsTexture = loadTexture("textures/mars.jpg");
-    unsigned int jupiterTexture = loadTexture("textures/jupiter.jpg");
-    unsigned int saturnTexture = loadTexture("textures/saturn.jpg");
-    unsigned int uranusTexture = loadTexture("textures/uranus.jpg");
-    unsigned int neptuneTexture = loadTexture("textures/neptune.jpg");
-    unsigned int moonTexture = loadTexture("textures/moon.jpg");
-    unsigned int saturnRingTexture = loadTexture("textures/saturn_ring.jpg");
-
-    unsigned int planetTextures[] = {
-    sunTexture,      // Słońce
-    mercuryTexture,  // Merkury
-    venusTexture,    // Wenus
-    earthTexture,    // Ziemia
-    marsTexture,     // Mars
-    jupiterTexture,  // Jowisz
-    saturnTexture,   // Saturn
-    uranusTexture,   // Uran
-    neptuneTexture,  // Neptun
-    moonTexture      // Księżyc
-    };
+    // N-body mode: the bodies start where their orbits put them, then only
+    // gravity moves them, in fixed ticks decoupled from the frames
+    SimulationThread simulation;
+    std::vector<glm::vec3> nbodyPositions;
+    double nbodyStartEnergy = 0.0;
+    double maxSimulationLag = 0.0;
+    if (nbody) {
+        std::vector<double> masses;
+        for (const SceneBody& body : scene.bodies)
+            masses.push_back(body.mass);
+        NBodySystem system = createNBodySystem(orbits, masses, scene.gravitationalConstant, startTime);
+        // Keeps close passes integrable without touching orbits that are
+        // whole units across
+        system.softening = 0.01;
+        TaskScheduler initialForces(1);
+        computeForces(system, initialForces);
+        nbodyStartEnergy = totalEnergy(system);
+        simulation.start(std::move(system), nbodyStep, simThreads, !(headless || bench) || simThread);
+    }
 
+    // Texture layers and the emissive flag never change; the transforms are
+    // rewritten from the orbits every frame
+    std::vector<PlanetInstance> planetInstances(orbits.size());
+    for (size_t i = 0; i < scene.bodies.size(); ++i) {
+        planetInstances[i].layer = (float)scene.bodies[i].textureLayer;
+        planetInstances[i].emissive = scene.bodies[i].emissive ? 1.0f : 0.0f;
+    }
+    // The same instances grouped by sphere LOD
+    std::vector<PlanetInstance> lodInstances;
+    std::vector<int> instanceLODs;
+    std::vector<int> lodCounts(sphereLevels);
+    std::vector<size_t> lodOffsets(sphereLevels);
+    size_t planetVertices = 0;
+    // Objects outside the view frustum are skipped, counted per frame
+    CullStats bodyCulling, ringCulling, orbitCulling;
+    // Bodies placed this frame, the others are stale
+    std::vector<unsigned char> bodyEvaluated;
+    size_t bodiesEvaluated = 0;
+    // Seconds since the scene's epoch; orbits and belts are closed-form
+    // functions of it, so jumping to any time costs nothing and any time
+    // warp costs the same per frame
+    double simulationTime = startTime;
+    int beltRebases = 0;
+
+
+    FrameBenchmark benchmark(bench ? warmupFrames : 0);
+    int totalFrames = frameCount + (bench ? warmupFrames : 0);
 
    // Render loop
-    while (!glfwWindowShouldClose(window)) {
-        // Per-frame time logic
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // Input
-        processInput(window);
-
-        // Render
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Activate shader
-        glUseProgram(shaderProgram);
+    int frame = 0;
+    while (!(window && glfwWindowShouldClose(window))) {
+        if ((headless || bench) && frame >= totalFrames)
+            break;
+        benchmark.beginFrame();
+
+        if (frame == 0) {
+            double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - programStart).count();
+            std::clog << "Startup: " << startupMs << " ms to the first frame" << std::endl;
+            benchmark.setValue("startup_ms", startupMs);
+        }
 
-        // Set lighting uniforms
-        glUniform3f(glGetUniformLocation(shaderProgram, "light.position"), lightPos.x, lightPos.y, lightPos.z);
-        glUniform3f(glGetUniformLocation(shaderProgram, "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+        // Upload texture layers decoded since the last frame
+        if (!textureLoader.done()) {
+            textureLoader.poll();
+        }
 
-        // Light properties
-        glUniform3f(glGetUniformLocation(shaderProgram, "light.ambient"), 0.2f, 0.2f, 0.2f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "light.diffuse"), 0.5f, 0.5f, 0.5f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "light.specular"), 1.0f, 1.0f, 1.0f);
+        // Recompile edited shaders, swap programs that finished linking
+        for (const std::string& path : shaderWatcher.takeChanged()) {
+            if (shader.usesFile(path))
+                shader.reload();
+            if (planetShader.usesFile(path))
+                planetShader.reload();
+            if (beltShader.usesFile(path))
+                beltShader.reload();
+        }
+        if (shader.pollReload()) {
+            uniforms = resolveSceneUniforms(shader);
+            setSceneShaderConstants(shader, uniforms, orbitLayer);
+        }
+        if (planetShader.pollReload()) {
+            setPlanetShaderConstants(planetShader);
+        }
+        if (beltShader.pollReload()) {
+            beltTime = beltShader.uniform<float>("time");
+            beltLayer = beltShader.uniform<float>("beltLayer");
+            setPlanetShaderConstants(beltShader);
+        }
 
-        // Material properties
-        glUniform3f(glGetUniformLocation(shaderProgram, "material.ambient"), 1.0f, 0.5f, 0.31f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "material.diffuse"), 1.0f, 0.5f, 0.31f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "material.specular"), 0.1f, 0.1f, 0.1f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "material.shininess"), 4.0f);
+        // Per-frame time logic
+        if (headless || bench) {
+            // Fixed simulated timestep so every run is reproducible
+            deltaTime = timestep;
+        }
+        else {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
 
-        // Set sun glow properties
-        glUniform3fv(glGetUniformLocation(shaderProgram, "sunColor"), 1, glm::value_ptr(sunColor));
-        glUniform1f(glGetUniformLocation(shaderProgram, "glowRadius"), glowRadius);
+            // Input
+            processInput(window);
+        }
 
-        // View/projection transformations
+        // View/projection transformations, the frustum also limits which
+        // bodies get placed
         glm::mat4 projection = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 100.0f);
         glm::mat4 view = glm::lookAt(cameraPos, cameraFront + cameraPos, cameraUp);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-
-        // Update orbit angles
-        for (unsigned int i = 1; i < sizeof(planetPositions) / sizeof(glm::vec3); ++i) {
-            orbitAngles[i] += orbitSpeeds[i] * deltaTime;
-            if (orbitAngles[i] > 360.0f) {
-                orbitAngles[i] -= 360.0f;
+        Frustum frustum = extractFrustum(projection * view);
+
+        // Evaluate the orbits at the current time: with culling only the
+        // systems that can reach the screen, otherwise every body
+        simulationTime += deltaTime * timeWarp.rate();
+        if (nbody) {
+            // Fixed ticks keep leapfrog symplectic; the frame shows the
+            // state one tick back, blended between the two ticks around it
+            simulation.advanceTo(simulationTime, timeWarp.rate());
+            simulation.sample(simulationTime, nbodyPositions);
+            // A warp beyond the tick budget slows the clock down instead
+            // of piling up ticks to catch up on
+            simulationTime = simulation.limitTime(simulationTime);
+            maxSimulationLag = std::max(maxSimulationLag, simulation.lag());
+            for (size_t i = 0; i < nbodyPositions.size(); ++i) {
+                PlanetInstance& instance = planetInstances[i];
+                float bodyScale = orbits.scale[i];
+                instance.model = glm::scale(glm::translate(glm::mat4(1.0f), nbodyPositions[i]), glm::vec3(bodyScale));
+                instance.normalMatrix = glm::mat3(1.0f / bodyScale);
             }
+            bodyEvaluated.assign(orbits.size(), 1);
+            bodiesEvaluated = orbits.size();
         }
-
-        // Update Moon's orbit angle
-        moonOrbitAngle += moonOrbitSpeed * deltaTime;
-        if (moonOrbitAngle > 360.0f) {
-            moonOrbitAngle -= 360.0f;
+        else if (frustumCulling) {
+            bodiesEvaluated = updateVisibleOrbits(orbits, simulationTime, frustum, planetInstances.data(), bodyEvaluated);
         }
-
-        // Render the orbits
-        for (unsigned int i = 1; i < sizeof(planetPositions) / sizeof(glm::vec3); ++i) {
-            drawOrbit(glm::length(planetPositions[i]), 100, view, projection, shaderProgram);
+        else {
+            updateOrbits(orbits, simulationTime, planetInstances.data());
+            applyHierarchy(orbits, planetInstances.data());
+            bodyEvaluated.assign(orbits.size(), 1);
+            bodiesEvaluated = orbits.size();
         }
+        // Keeps the belt shader's float time small
+        for (Belt& belt : belts) {
+            if (updateBeltEpoch(belt, simulationTime))
+                ++beltRebases;
+        }
+        benchmark.endPhase(PHASE_UPDATE);
 
-        // Render the planets and their moons
-        for (unsigned int i = 0; i < sizeof(planetPositions) / sizeof(glm::vec3); ++i) {
-            glm::mat4 model = glm::mat4(1.0f);
+        // Render
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            // Orbita
-            if (i > 0) {
-                float orbitRadius = glm::length(planetPositions[i]);
-                float x = cos(glm::radians(orbitAngles[i])) * orbitRadius;
-                float z = sin(glm::radians(orbitAngles[i])) * orbitRadius;
-                model = glm::translate(model, glm::vec3(x, 0.0f, z));
-            }
-            else {
-                model = glm::translate(model, planetPositions[i]);
+        // Activate shader
+        shader.use();
+
+        frameData.view = view;
+        frameData.projection = projection;
+        frameData.viewPos = cameraPos;
+        updateUniformBuffer(frameUBO, sizeof(FrameBlock), &frameData);
+        bodyCulling.reset();
+        ringCulling.reset();
+        orbitCulling.reset();
+        benchmark.endPhase(PHASE_SETUP);
+
+        // Render the orbits, around the parent's current position. A body
+        // that was not evaluated belongs to a system that is off screen,
+        // and so does its orbit.
+        uniforms.textureLayer.set(orbitLayer);
+        for (size_t i = 0; i < scene.bodies.size(); ++i) {
+            const SceneBody& body = scene.bodies[i];
+            if (!body.orbitLine || nbody)
+                continue;
+            if (!bodyEvaluated[i]) {
+                orbitCulling.count(false);
+                continue;
             }
+            glm::vec3 center = body.parent >= 0 ? glm::vec3(planetInstances[body.parent].model[3]) : glm::vec3(0.0f);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), center) * orbitMatrices[i];
+            bool visible = !frustumCulling
+                || discInFrustum(frustum, glm::vec3(model[3]), glm::vec3(model[1]), body.orbitRadius);
+            if (orbitCulling.count(visible))
+                drawOrbit(orbitGeometry, model, uniforms);
+        }
+        benchmark.endPhase(PHASE_ORBITS);
+
+        // Rings, each with its own texture layer
+        for (size_t i = 0; i < scene.rings.size(); ++i) {
+            const SceneRing& ring = scene.rings[i];
+            glm::vec3 center = glm::vec3(planetInstances[ring.body].model[3]);
+            bool visible = bodyEvaluated[ring.body]
+                && (!frustumCulling || horizontalDiscInFrustum(frustum, center, ring.radius + ring.width / 2.0f));
+            if (!ringCulling.count(visible))
+                continue;
+            setModelMatrix(uniforms, glm::translate(glm::mat4(1.0f), center));
+            uniforms.textureLayer.set((float)ring.textureLayer);
+
+            glBindVertexArray(ringMeshes[i].VAO);
+            glDrawElements(GL_TRIANGLES, ringMeshes[i].indexCount, ringMeshes[i].indexType, 0);
+        }
 
-            model = glm::scale(model, planetScales[i]);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(glGetUniformLocation(shaderProgram, "isSun"), (i == 0) ? 1 : 0);
-
-            // Bind the texture
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, planetTextures[i]);
-            glUniform1i(glGetUniformLocation(shaderProgram, "material.texture_diffuse"), 0);
-
-            glBindVertexArray(VAO);
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-
-            // Renderowanie pierścienia Saturna
-            if (i == 6) {
-                glm::mat4 ringModel = glm::mat4(1.0f);
-                float saturnOrbitRadius = glm::length(planetPositions[6]);
-                float saturnX = cos(glm::radians(orbitAngles[6])) * saturnOrbitRadius;
-                float saturnZ = sin(glm::radians(orbitAngles[6])) * saturnOrbitRadius;
-                ringModel = glm::translate(ringModel, glm::vec3(saturnX, 0.0f, saturnZ));
-                glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(ringModel));
-
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, saturnRingTexture);
-                glUniform1i(glGetUniformLocation(shaderProgram, "material.texture_diffuse"), 0);
-
-                glBindVertexArray(flatRingVAO);
-                glDrawElements(GL_TRIANGLES, flatRingIndices.size(), GL_UNSIGNED_INT, 0);
+        // Pick a sphere LOD per body from its projected radius in pixels,
+        // bodies outside the frustum get no level (-1) and are dropped
+        int framebufferHeight = height;
+        if (window) {
+            int framebufferWidth;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        }
+        float pixelsPerUnit = framebufferHeight * 0.5f / tan(glm::radians(fov) * 0.5f);
+        instanceLODs.resize(planetInstances.size());
+        std::fill(lodCounts.begin(), lodCounts.end(), 0);
+        for (size_t i = 0; i < planetInstances.size(); ++i) {
+            const glm::mat4& model = planetInstances[i].model;
+            float bodyRadius = 0.5f * glm::length(glm::vec3(model[0]));
+            bool visible = bodyEvaluated[i]
+                && (!frustumCulling || sphereInFrustum(frustum, glm::vec3(model[3]), bodyRadius));
+            if (!bodyCulling.count(visible)) {
+                instanceLODs[i] = -1;
+                continue;
             }
+            float distance = glm::length(glm::vec3(model[3]) - cameraPos);
+            // Inside the sphere it covers the whole screen
+            float screenRadius = distance > bodyRadius ? bodyRadius * pixelsPerUnit / distance : (float)framebufferHeight;
+            instanceLODs[i] = selectSphereLOD(sphereMesh, screenRadius);
+            ++lodCounts[instanceLODs[i]];
         }
 
-        // Renderowanie księżyca Ziemi
-        float earthOrbitRadius = glm::length(planetPositions[3]);
-        float earthX = cos(glm::radians(orbitAngles[3])) * earthOrbitRadius;
-        float earthZ = sin(glm::radians(orbitAngles[3])) * earthOrbitRadius;
-        glm::vec3 earthPos = glm::vec3(earthX, 0.0f, earthZ);
-
-        float moonX = cos(glm::radians(moonOrbitAngle)) * moonOrbitRadius;
-        float moonZ = sin(glm::radians(moonOrbitAngle)) * moonOrbitRadius;
+        // Group the instances by level, one instanced draw per level in use
+        lodInstances.resize(bodyCulling.drawn);
+        lodOffsets[0] = 0;
+        for (size_t level = 1; level < sphereLevels; ++level)
+            lodOffsets[level] = lodOffsets[level - 1] + lodCounts[level - 1];
+        for (size_t i = 0; i < planetInstances.size(); ++i) {
+            if (instanceLODs[i] >= 0)
+                lodInstances[lodOffsets[instanceLODs[i]]++] = planetInstances[i];
+        }
 
-        glm::mat4 moonModel = glm::mat4(1.0f);
-        moonModel = glm::translate(moonModel, earthPos + glm::vec3(moonX, 0.0f, moonZ));
-        moonModel = glm::scale(moonModel, glm::vec3(size_factor * 0.273f, size_factor * 0.273f, size_factor * 0.273f));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(moonModel));
-        glUniform1i(glGetUniformLocation(shaderProgram, "isSun"), 0);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, lodInstances.size() * sizeof(PlanetInstance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, lodInstances.size() * sizeof(PlanetInstance), lodInstances.data());
+
+        // The spheres are closed and convex: culling their back faces
+        // removes all of their self-overdraw
+        glEnable(GL_CULL_FACE);
+        planetShader.use();
+        glBindVertexArray(sphereMesh.VAO);
+        size_t firstInstance = 0;
+        planetVertices = 0;
+        for (size_t level = 0; level < sphereLevels; ++level) {
+            if (lodCounts[level] == 0)
+                continue;
+            const SphereLOD& lod = sphereMesh.levels[level];
+            // There is no base instance before GL 4.2, so the attributes are
+            // pointed at the level's group instead
+            setPlanetInstanceAttributes(firstInstance);
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.indexCount, sphereMesh.indexType,
+                (void*)((size_t)lod.firstIndex * sphereMesh.indexSize), lodCounts[level], lod.baseVertex);
+            firstInstance += lodCounts[level];
+            planetVertices += (size_t)lod.indexCount * lodCounts[level];
+        }
+        benchmark.endPhase(PHASE_PLANETS);
+
+        // Belts: one instanced draw each, positions come from the time
+        if (!belts.empty()) {
+            beltShader.use();
+            for (const Belt& belt : belts) {
+                beltTime.set((float)(simulationTime - belt.epoch));
+                beltLayer.set(belt.textureLayer);
+                drawBelt(belt, sphereMesh);
+            }
+        }
+        glDisable(GL_CULL_FACE);
+        benchmark.endPhase(PHASE_BELTS);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, moonTexture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "material.texture_diffuse"), 0);
+        // Swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        if (headless) {
+            glFinish();
+        }
+        else {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        benchmark.endPhase(PHASE_SWAP);
+        benchmark.endFrame();
+        ++frame;
+    }
 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    if (headless && outputPath) {
+        writeFramebufferPPM(outputPath, width, height);
+    }
 
-        // Swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (bench) {
+        benchmark.setValue("width", width);
+        benchmark.setValue("height", height);
+        benchmark.setValue("texture_load_ms", textureLoader.elapsedMilliseconds());
+        benchmark.setValue("texture_mb", textureLoader.memoryBytes() / (1024.0 * 1024.0));
+        benchmark.setValue("sphere_vertices", sphereMesh.vertexCount);
+        benchmark.setValue("sphere_vertex_bytes", vertexStride(sphereMesh.format));
+        benchmark.setValue("planet_vertices_per_frame", (double)planetVertices);
+        benchmark.setValue("belt_bodies", beltBodies);
+        benchmark.setValue("belt_vertices_per_frame", (double)beltBodies * sphereMesh.levels[0].indexCount);
+        // Culling counts of the last frame
+        benchmark.setValue("bodies_evaluated", (double)bodiesEvaluated);
+        benchmark.setValue("time_warp", timeWarp.rate());
+        benchmark.setValue("simulated_seconds", simulationTime - startTime);
+        benchmark.setValue("belt_rebases", beltRebases);
+        if (nbody) {
+            simulation.stop();
+            benchmark.setValue("sim_threaded", simThread ? 1 : 0);
+            benchmark.setValue("sim_ticks", (double)simulation.tickCount());
+            benchmark.setValue("sim_step_ms", simulation.meanStepMilliseconds());
+            benchmark.setValue("sim_max_lag_ms", maxSimulationLag * 1000.0);
+            benchmark.setValue("nbody_energy_drift", energyDrift(nbodyStartEnergy, totalEnergy(simulation.system())));
+        }
+        benchmark.setValue("bodies_drawn", bodyCulling.drawn);
+        benchmark.setValue("bodies_culled", bodyCulling.culled);
+        benchmark.setValue("rings_drawn", ringCulling.drawn);
+        benchmark.setValue("rings_culled", ringCulling.culled);
+        benchmark.setValue("orbits_drawn", orbitCulling.drawn);
+        benchmark.setValue("orbits_culled", orbitCulling.culled);
+        benchmark.writeJSON(benchOutputPath, (const char*)glGetString(GL_RENDERER), timestep);
     }
 
     // Clean up
-    glDeleteVertexArrays(1, &flatRingVAO);
-    glDeleteBuffers(1, &flatRingVBO);
-    glDeleteBuffers(1, &flatRingEBO);
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glfwTerminate();
+    shaderWatcher.stop();
+    deleteOrbitGeometry(orbitGeometry);
+    for (RingMesh& ring : ringMeshes)
+        deleteRingMesh(ring);
+    deleteSphereMeshSet(sphereMesh);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteTextures(1, &planetTextureArray);
+    glDeleteBuffers(1, &frameUBO);
+    glDeleteBuffers(1, &lightingUBO);
+    shader.destroy();
+    planetShader.destroy();
+    beltShader.destroy();
+    for (Belt& belt : belts)
+        deleteBelt(belt);
+    if (headless) {
+        destroyHeadlessContext(headlessContext);
+    }
+    else {
+        glfwTerminate();
+    }
 
     return 0;
 }
@@ -477,6 +866,11 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (pitch < -89.0f)
         pitch = -89.0f;
 
+    updateCameraFront();
+}
+
+// Recompute the camera direction from the yaw/pitch angles
+void updateCameraFront() {
     glm::vec3 front;
     front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
     front.y = sin(glm::radians(pitch));
@@ -494,6 +888,30 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
         fov = 45.0f;
 }
 
+// GLFW: single key presses, held keys are polled in processInput.
+// Space pauses, R reverses, period/comma make time run 10x faster/slower.
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    switch (key) {
+    case GLFW_KEY_SPACE:
+        timeWarp.paused = !timeWarp.paused;
+        break;
+    case GLFW_KEY_R:
+        timeWarp.reversed = !timeWarp.reversed;
+        break;
+    case GLFW_KEY_PERIOD:
+        timeWarp.faster();
+        break;
+    case GLFW_KEY_COMMA:
+        timeWarp.slower();
+        break;
+    default:
+        return;
+    }
+    std::clog << "Time warp: " << timeWarp.label() << std::endl;
+}
+
 std::vector<float> generateFlatRingVertices(float radius, float ringWidth, int segments) {
     std::vector<float> vertices;
     float innerRadius = radius - ringWidth / 2.0f;
@@ -536,203 +954,152 @@ std::vector<unsigned int> generateFlatRingIndices(int segments) {
     return indices;
 }
 
-std::vector<float> generateSphereVertices(float radius, int sectorCount, int stackCount) {
-    std::vector<float> vertices;
-    float x, y, z, xy;
-    float nx, ny, nz, lengthInv = 1.0f / radius;
-    float s, t;
-
-    float sectorStep = 2 * glm::pi<float>() / sectorCount;
-    float stackStep = glm::pi<float>() / stackCount;
-    float sectorAngle, stackAngle;
-
-    for (int i = 0; i <= stackCount; ++i) {
-        stackAngle = glm::pi<float>() / 2 - i * stackStep;
-        xy = radius * cosf(stackAngle);
-        z = radius * sinf(stackAngle);
-
-        for (int j = 0; j <= sectorCount; ++j) {
-            sectorAngle = j * sectorStep;
-
-            x = xy * cosf(sectorAngle);
-            y = xy * sinf(sectorAngle);
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-
-            s = (float)j / sectorCount;
-            t = (float)i / stackCount;
-
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
-            vertices.push_back(s);
-            vertices.push_back(t);
-        }
+void setPlanetInstanceAttributes(size_t firstInstance) {
+    size_t base = firstInstance * sizeof(PlanetInstance);
+    // Model matrix, one column per attribute slot
+    for (int column = 0; column < 4; ++column) {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(PlanetInstance), (void*)(base + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
     }
-    return vertices;
+    // Texture layer + emissive flag
+    glVertexAttribPointer(7, 2, GL_FLOAT, GL_FALSE, sizeof(PlanetInstance), (void*)(base + offsetof(PlanetInstance, layer)));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+    // Normal matrix, one column per attribute slot
+    for (int column = 0; column < 3; ++column) {
+        glVertexAttribPointer(8 + column, 3, GL_FLOAT, GL_FALSE, sizeof(PlanetInstance),
+            (void*)(base + offsetof(PlanetInstance, normalMatrix) + column * sizeof(glm::vec3)));
+        glEnableVertexAttribArray(8 + column);
+        glVertexAttribDivisor(8 + column, 1);
+    }
+}
+
+SceneUniforms resolveSceneUniforms(const Shader& shader) {
+    SceneUniforms u;
+    u.model = shader.uniform<glm::mat4>("model");
+    u.normalMatrix = shader.uniform<glm::mat3>("normalMatrix");
+    u.textures = shader.uniform<int>("textures");
+    u.textureLayer = shader.uniform<float>("textureLayer");
+    u.isSun = shader.uniform<int>("isSun");
+    return u;
+}
+
+void setModelMatrix(const SceneUniforms& uniforms, const glm::mat4& model) {
+    // Once per draw instead of an inverse per vertex in the shader
+    uniforms.model.set(model);
+    uniforms.normalMatrix.set(glm::inverseTranspose(glm::mat3(model)));
+}
+
+void setSceneShaderConstants(const Shader& shader, const SceneUniforms& uniforms, float orbitLayer) {
+    // The texture array always comes from unit 0, and this shader only
+    // draws lit geometry (orbits, rings) now
+    shader.use();
+    uniforms.textures.set(0);
+    uniforms.isSun.set(0);
+
+    // Orbits are shaded with the scene's orbit texture, rings set their own
+    uniforms.textureLayer.set(orbitLayer);
 }
 
-void drawOrbit(float radius, int segments, glm::mat4 view, glm::mat4 projection, unsigned int shaderProgram) {
+void setPlanetShaderConstants(const Shader& planetShader) {
+    planetShader.use();
+    planetShader.uniform<int>("planetTextures").set(0);
+}
+
+OrbitGeometry createOrbitGeometry(int segments) {
     std::vector<float> vertices;
+    vertices.reserve((segments + 1) * 3);
     for (int i = 0; i <= segments; ++i) {
         float theta = i * 2.0f * glm::pi<float>() / segments;
-        float x = radius * cos(theta);
-        float z = radius * sin(theta);
-        vertices.push_back(x);
+        vertices.push_back(cos(theta));
         vertices.push_back(0.0f);
-        vertices.push_back(z);
+        vertices.push_back(sin(theta));
     }
 
-    unsigned int VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    OrbitGeometry orbit;
+    orbit.segments = segments;
+    glGenVertexArrays(1, &orbit.VAO);
+    glGenBuffers(1, &orbit.VBO);
 
-    glBindVertexArray(VAO);
+    glBindVertexArray(orbit.VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, orbit.VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Use the shader program
-    glUseProgram(shaderProgram);
+    return orbit;
+}
 
-    // Set view and projection matrices
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "planetColor"), 1, glm::value_ptr(glm::vec3(1.5f, 1.5f, 1.5f)));
+void deleteOrbitGeometry(OrbitGeometry& orbit) {
+    glDeleteVertexArrays(1, &orbit.VAO);
+    glDeleteBuffers(1, &orbit.VBO);
+    orbit.VAO = orbit.VBO = 0;
+}
 
-    // Set the model matrix to identity
-    glm::mat4 model = glm::mat4(1.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+// Expects the planet shader to be bound and the frame UBO to be up to date
+void drawOrbit(const OrbitGeometry& orbit, const glm::mat4& model, const SceneUniforms& uniforms) {
+    // The model matrix maps the unit circle onto the orbit ellipse
+    setModelMatrix(uniforms, model);
 
     // Draw the orbit
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_LINE_LOOP, 0, segments);
-
-    // Clean up
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    glBindVertexArray(orbit.VAO);
+    glDrawArrays(GL_LINE_LOOP, 0, orbit.segments);
 }
 
+RingMesh createRingMesh(float radius, float ringWidth, int segments, VertexFormat format) {
+    std::vector<float> vertices = generateFlatRingVertices(radius, ringWidth, segments);
+    std::vector<unsigned int> indices = generateFlatRingIndices(segments);
+
+    RingMesh ring;
+    ring.indexCount = (int)indices.size();
+    glGenVertexArrays(1, &ring.VAO);
+    glGenBuffers(1, &ring.VBO);
+    glGenBuffers(1, &ring.EBO);
+
+    glBindVertexArray(ring.VAO);
+
+    // Packed: half float positions (padded to 8 bytes) and 16-bit indices
+    if (format == VERTEX_PACKED) {
+        std::vector<uint16_t> packedVertices;
+        for (size_t i = 0; i < vertices.size(); i += 3) {
+            packedVertices.push_back(floatToHalf(vertices[i]));
+            packedVertices.push_back(floatToHalf(vertices[i + 1]));
+            packedVertices.push_back(floatToHalf(vertices[i + 2]));
+            packedVertices.push_back(floatToHalf(1.0f));
+        }
+        std::vector<unsigned short> packedIndices(indices.begin(), indices.end());
+        ring.indexType = GL_UNSIGNED_SHORT;
 
+        glBindBuffer(GL_ARRAY_BUFFER, ring.VBO);
+        glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(uint16_t), packedVertices.data(), GL_STATIC_DRAW);
 
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ring.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, packedIndices.size() * sizeof(unsigned short), packedIndices.data(), GL_STATIC_DRAW);
 
-// Utility function for loading a shader
-unsigned int loadShader(const char* vertexPath, const char* fragmentPath) {
-    // Retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // Ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // Read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // Close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    }
-    catch (std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-    }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    // Compile shaders
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
-
-    // Vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    // Print compile errors if any
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-            << infoLog << std::endl;
-    }
-
-    // Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    // Print compile errors if any
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-            << infoLog << std::endl;
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, 4 * sizeof(uint16_t), (void*)0);
     }
+    else {
+        ring.indexType = GL_UNSIGNED_INT;
 
-    // Shader Program
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertex);
-    glAttachShader(shaderProgram, fragment);
-    glLinkProgram(shaderProgram);
-    // Print linking errors if any
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-            << infoLog << std::endl;
-    }
-    // Delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+        glBindBuffer(GL_ARRAY_BUFFER, ring.VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-    return shaderProgram;
-}
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ring.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
-unsigned int loadTexture(const char* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else {
-        std::cout << "Failed to load texture: " << path << std::endl;
-        stbi_image_free(data);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     }
+    glEnableVertexAttribArray(0);
 
-    return textureID;
+    return ring;
 }
 
+void deleteRingMesh(RingMesh& ring) {
+    glDeleteVertexArrays(1, &ring.VAO);
+    glDeleteBuffers(1, &ring.VBO);
+    glDeleteBuffers(1, &ring.EBO);
+    ring.VAO = ring.VBO = ring.EBO = 0;
+}
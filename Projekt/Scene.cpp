@@ -0,0 +1,228 @@
+#include <glm/glm.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include "AssetPack.h"
+#include "Json.h"
+#include "Scene.h"
+
+// Layer of the texture path, added on first use
+static int textureLayer(Scene& scene, std::unordered_map<std::string, int>& layers, const std::string& path) {
+    auto it = layers.find(path);
+    if (it != layers.end())
+        return it->second;
+    int layer = (int)scene.textures.size();
+    scene.textures.push_back(path);
+    layers[path] = layer;
+    return layer;
+}
+
+// Reorders the bodies depth first from the roots (file order among
+// siblings), so every parent precedes its children and each subtree is one
+// contiguous run. parents holds the file-order parent of every body.
+static bool sortBodies(std::vector<SceneBody>& bodies, const std::vector<int>& parents, std::vector<int>& newIndex) {
+    const int count = (int)bodies.size();
+    std::vector<std::vector<int>> children(count);
+    std::vector<int> roots;
+    for (int i = 0; i < count; ++i) {
+        if (parents[i] < 0)
+            roots.push_back(i);
+        else
+            children[parents[i]].push_back(i);
+    }
+
+    // Explicit stack, chains of satellites can be arbitrarily deep
+    std::vector<int> order;
+    order.reserve(count);
+    std::vector<int> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty()) {
+        int body = stack.back();
+        stack.pop_back();
+        order.push_back(body);
+        stack.insert(stack.end(), children[body].rbegin(), children[body].rend());
+    }
+    // Bodies on a parent cycle are never reached from a root
+    if ((int)order.size() != count) {
+        std::vector<bool> placed(count, false);
+        for (int body : order)
+            placed[body] = true;
+        for (int i = 0; i < count; ++i) {
+            if (!placed[i]) {
+                std::cerr << "ERROR::SCENE::PARENT_CYCLE " << bodies[i].name << std::endl;
+                break;
+            }
+        }
+        return false;
+    }
+
+    newIndex.assign(count, -1);
+    for (int i = 0; i < count; ++i)
+        newIndex[order[i]] = i;
+    std::vector<SceneBody> sorted(count);
+    for (int i = 0; i < count; ++i) {
+        sorted[i] = std::move(bodies[order[i]]);
+        sorted[i].parent = parents[order[i]] < 0 ? -1 : newIndex[parents[order[i]]];
+    }
+    bodies.swap(sorted);
+    return true;
+}
+
+bool loadScene(const char* path, Scene& scene) {
+    std::string text;
+    size_t packedSize = 0;
+    const unsigned char* packed = findAsset(path, packedSize);
+    if (packed) {
+        text.assign((const char*)packed, packedSize);
+    }
+    else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "ERROR::SCENE::FILE_NOT_FOUND " << path << std::endl;
+            return false;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        text = stream.str();
+    }
+
+    JsonValue root;
+    std::string error;
+    if (!parseJson(text, root, error)) {
+        std::cerr << "ERROR::SCENE::PARSE_FAILED " << path << ": " << error << std::endl;
+        return false;
+    }
+    const JsonValue* bodies = root.find("bodies");
+    if (!bodies || bodies->type != JsonValue::ARRAY || bodies->array.empty()) {
+        std::cerr << "ERROR::SCENE::NO_BODIES " << path << std::endl;
+        return false;
+    }
+
+    scene = Scene();
+    std::unordered_map<std::string, int> layers;
+    std::unordered_map<std::string, int> bodyIndices;
+    std::vector<std::string> parentNames;
+    for (const JsonValue& entry : bodies->array) {
+        SceneBody body;
+        body.name = entry.getString("name", "");
+        std::string texture = entry.getString("texture", "");
+        std::string parent = entry.getString("parent", "");
+        if (texture.empty()) {
+            std::cerr << "ERROR::SCENE::BODY_WITHOUT_TEXTURE " << body.name << std::endl;
+            return false;
+        }
+        if (!body.name.empty() && bodyIndices.count(body.name)) {
+            std::cerr << "ERROR::SCENE::DUPLICATE_BODY " << body.name << std::endl;
+            return false;
+        }
+        body.orbitRadius = (float)entry.getNumber("orbitRadius", 0.0);
+        body.orbitSpeed = glm::radians((float)entry.getNumber("orbitSpeed", 0.0));
+        body.orbitAngle = glm::radians((float)entry.getNumber("orbitAngle", 0.0));
+        body.eccentricity = (float)entry.getNumber("eccentricity", 0.0);
+        body.inclination = glm::radians((float)entry.getNumber("inclination", 0.0));
+        body.ascendingNode = glm::radians((float)entry.getNumber("ascendingNode", 0.0));
+        body.argumentOfPeriapsis = glm::radians((float)entry.getNumber("argumentOfPeriapsis", 0.0));
+        body.scale = (float)entry.getNumber("scale", 1.0);
+        if (body.scale <= 0.0f) {
+            std::cerr << "ERROR::SCENE::BAD_SCALE " << body.name << std::endl;
+            return false;
+        }
+        // Parabolic and hyperbolic paths have no closed-form period, and
+        // nearly parabolic ones need more Kepler iterations than the kernel runs
+        if (body.eccentricity < 0.0f || body.eccentricity > MAX_ECCENTRICITY) {
+            std::cerr << "ERROR::SCENE::BAD_ECCENTRICITY " << body.name << std::endl;
+            return false;
+        }
+        body.textureLayer = textureLayer(scene, layers, texture);
+        body.mass = entry.getNumber("mass", 0.0);
+        if (body.mass < 0.0) {
+            std::cerr << "ERROR::SCENE::BAD_MASS " << body.name << std::endl;
+            return false;
+        }
+        body.emissive = entry.getBool("emissive", false);
+        body.orbitLine = entry.getBool("orbitLine", parent.empty() && body.orbitRadius > 0.0f);
+
+        if (!body.name.empty())
+            bodyIndices[body.name] = (int)scene.bodies.size();
+        scene.bodies.push_back(body);
+        parentNames.push_back(parent);
+    }
+
+    // Parents may be listed anywhere in the file
+    std::vector<int> parents(scene.bodies.size(), -1);
+    for (size_t i = 0; i < scene.bodies.size(); ++i) {
+        if (parentNames[i].empty())
+            continue;
+        auto it = bodyIndices.find(parentNames[i]);
+        if (it == bodyIndices.end()) {
+            std::cerr << "ERROR::SCENE::UNKNOWN_PARENT " << parentNames[i] << " of " << scene.bodies[i].name << std::endl;
+            return false;
+        }
+        parents[i] = it->second;
+    }
+    std::vector<int> newIndex;
+    if (!sortBodies(scene.bodies, parents, newIndex))
+        return false;
+    for (auto& entry : bodyIndices)
+        entry.second = newIndex[entry.second];
+
+    const JsonValue* rings = root.find("rings");
+    if (rings && rings->type == JsonValue::ARRAY) {
+        for (const JsonValue& entry : rings->array) {
+            SceneRing ring;
+            std::string body = entry.getString("body", "");
+            auto it = bodyIndices.find(body);
+            if (it == bodyIndices.end()) {
+                std::cerr << "ERROR::SCENE::UNKNOWN_RING_BODY " << body << std::endl;
+                return false;
+            }
+            ring.body = it->second;
+            ring.radius = (float)entry.getNumber("radius", 1.0);
+            ring.width = (float)entry.getNumber("width", 0.0);
+            std::string texture = entry.getString("texture", "");
+            if (texture.empty()) {
+                std::cerr << "ERROR::SCENE::RING_WITHOUT_TEXTURE " << body << std::endl;
+                return false;
+            }
+            ring.textureLayer = textureLayer(scene, layers, texture);
+            scene.rings.push_back(ring);
+        }
+    }
+
+    const JsonValue* belts = root.find("belts");
+    if (belts && belts->type == JsonValue::ARRAY) {
+        for (const JsonValue& entry : belts->array) {
+            SceneBelt belt;
+            belt.name = entry.getString("name", "");
+            belt.count = (int)entry.getNumber("count", 0.0);
+            belt.innerRadius = (float)entry.getNumber("innerRadius", 1.0);
+            belt.outerRadius = (float)entry.getNumber("outerRadius", belt.innerRadius);
+            belt.orbitSpeed = glm::radians((float)entry.getNumber("orbitSpeed", 0.0));
+            belt.inclination = glm::radians((float)entry.getNumber("inclination", 0.0));
+            belt.minScale = (float)entry.getNumber("minScale", 0.01);
+            belt.maxScale = (float)entry.getNumber("maxScale", belt.minScale);
+            belt.seed = (unsigned int)entry.getNumber("seed", 1.0);
+            std::string texture = entry.getString("texture", "");
+            if (texture.empty() || belt.count < 0 || belt.innerRadius <= 0.0f || belt.outerRadius < belt.innerRadius) {
+                std::cerr << "ERROR::SCENE::BAD_BELT " << belt.name << std::endl;
+                return false;
+            }
+            belt.textureLayer = textureLayer(scene, layers, texture);
+            scene.belts.push_back(belt);
+        }
+    }
+
+    scene.gravitationalConstant = root.getNumber("gravitationalConstant", 1.0);
+
+    // Orbit lines fall back to the first ring's (or body's) texture
+    std::string orbitTexture = root.getString("orbitTexture", "");
+    if (!orbitTexture.empty())
+        scene.orbitTextureLayer = textureLayer(scene, layers, orbitTexture);
+    else
+        scene.orbitTextureLayer = scene.rings.empty() ? 0 : scene.rings[0].textureLayer;
+
+    std::clog << "Scene " << path << ": " << scene.bodies.size() << " bodies, " << scene.rings.size()
+        << " rings, " << scene.belts.size() << " belts, " << scene.textures.size() << " textures" << std::endl;
+    return true;
+}
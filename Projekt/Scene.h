@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Scene description loaded from a JSON file (scenes/solar_system.json):
+//
+// {
+//   "orbitTexture": "textures/saturn_ring.jpg",
+//   "bodies": [
+//     { "name": "Sun", "texture": "textures/sun.jpg", "scale": 10, "emissive": true },
+//     { "name": "Earth", "texture": "textures/earth.jpg", "orbitRadius": 15, "orbitSpeed": 40, "scale": 0.6 },
+//     { "name": "Moon", "parent": "Earth", "texture": "textures/moon.jpg", "orbitRadius": 1, ... }
+//   ],
+//   "rings": [ { "body": "Saturn", "texture": "textures/saturn_ring.jpg", "radius": 4.5, "width": 1.7 } ],
+//   "belts": [ { "name": "Asteroid belt", "texture": "textures/moon.jpg", "count": 100000,
+//                "innerRadius": 20, "outerRadius": 22.5, "orbitSpeed": 13.3, "inclination": 6,
+//                "minScale": 0.015, "maxScale": 0.07, "seed": 1 } ]
+// }
+//
+// Orbits are Keplerian ellipses around the parent, or the origin when a
+// body has none; parents can be nested to any depth and listed anywhere in
+// the file. orbitRadius is the semi-major axis, orbitSpeed the mean motion
+// and orbitAngle the mean anomaly at time 0, optionally with "eccentricity",
+// "inclination" (out of the xz plane), "ascendingNode" and
+// "argumentOfPeriapsis". Angles are given in degrees (per second), scale is
+// the diameter of the body's sphere. The N-body mode (see NBody.h) uses
+// each body's "mass" and the file's "gravitationalConstant" instead of the
+// scripted speeds. The default scene gives real masses in solar masses;
+// its moons orbit far outside their planets' Hill spheres, so under
+// gravity alone they drift off into orbits of their own around the Sun.
+
+// Highest eccentricity the loader accepts: the orbit kernel's fixed number
+// of Halley steps (OrbitSimulation.cpp) only converges up to here
+const float MAX_ECCENTRICITY = 0.99f;
+
+struct SceneBody {
+    std::string name;
+    int parent = -1;          // index into Scene::bodies, always lower than this body's
+    float orbitRadius = 0.0f;           // semi-major axis
+    float orbitSpeed = 0.0f;            // mean motion, radians per second
+    float orbitAngle = 0.0f;            // mean anomaly at time 0, radians
+    float eccentricity = 0.0f;          // [0, MAX_ECCENTRICITY]
+    float inclination = 0.0f;           // radians
+    float ascendingNode = 0.0f;         // radians
+    float argumentOfPeriapsis = 0.0f;   // radians
+    float scale = 1.0f;
+    int textureLayer = 0;     // into Scene::textures
+    double mass = 0.0;        // only used by the N-body mode, 0 = test particle
+    bool emissive = false;    // unlit, like the Sun
+    bool orbitLine = true;    // draw the orbit; defaults to bodies without a parent
+};
+
+// Procedural belt of small bodies around the origin, see Belt.h.
+// orbitSpeed is the angular speed at innerRadius, farther bodies follow
+// Kepler's third law; inclination is the maximum tilt of an orbit.
+struct SceneBelt {
+    std::string name;
+    int count = 0;
+    float innerRadius = 1.0f;
+    float outerRadius = 1.0f;
+    float orbitSpeed = 0.0f;   // radians per second
+    float inclination = 0.0f;  // radians
+    float minScale = 0.01f;
+    float maxScale = 0.01f;
+    unsigned int seed = 1;
+    int textureLayer = 0;
+};
+
+struct SceneRing {
+    int body = 0;
+    float radius = 1.0f;      // middle of the ring
+    float width = 0.0f;
+    int textureLayer = 0;
+};
+
+// Flat store: bodies are sorted depth first, so every parent precedes its
+// children and each subtree is contiguous. One pass over the array in order
+// places every body relative to its already placed parent.
+struct Scene {
+    std::vector<SceneBody> bodies;
+    std::vector<SceneRing> rings;
+    std::vector<SceneBelt> belts;
+    std::vector<std::string> textures;  // one texture array layer each
+    int orbitTextureLayer = 0;
+    double gravitationalConstant = 1.0;  // N-body mode, in scene units
+};
+
+// Reads the file from the mounted asset pack or from disk. Unknown or
+// duplicate body names, parent cycles, bodies without a texture,
+// non-positive scales, negative masses and non-elliptic orbits are reported
+// and fail the load.
+bool loadScene(const char* path, Scene& scene);
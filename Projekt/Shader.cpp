@@ -0,0 +1,343 @@
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "AssetPack.h"
+#include "GLExtensions.h"
+#include "ProgramCache.h"
+#include "Shader.h"
+#include "UniformBuffers.h"
+
+// #version has to stay the first line, the defines go right after it
+static void insertDefines(std::string& code, const std::string& defines) {
+    if (defines.empty())
+        return;
+    size_t position = 0;
+    if (code.compare(0, 8, "#version") == 0) {
+        position = code.find('\n');
+        position = position == std::string::npos ? code.size() : position + 1;
+    }
+    code.insert(position, defines);
+}
+
+// Utility function for loading a shader
+unsigned int loadShader(const char* vertexPath, const char* fragmentPath, const std::string& defines) {
+    // Retrieve the vertex/fragment source code from filePath
+    std::string vertexCode;
+    std::string fragmentCode;
+    size_t vertexSize = 0, fragmentSize = 0;
+    const unsigned char* vertexPacked = findAsset(vertexPath, vertexSize);
+    const unsigned char* fragmentPacked = findAsset(fragmentPath, fragmentSize);
+    std::ifstream vShaderFile;
+    std::ifstream fShaderFile;
+    // Ensure ifstream objects can throw exceptions:
+    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    if (vertexPacked && fragmentPacked) {
+        // Both sources are in the mounted asset pack
+        vertexCode.assign((const char*)vertexPacked, vertexSize);
+        fragmentCode.assign((const char*)fragmentPacked, fragmentSize);
+    }
+    else {
+        try {
+            // Open files
+            vShaderFile.open(vertexPath);
+            fShaderFile.open(fragmentPath);
+            std::stringstream vShaderStream, fShaderStream;
+            // Read file's buffer contents into streams
+            vShaderStream << vShaderFile.rdbuf();
+            fShaderStream << fShaderFile.rdbuf();
+            // Close file handlers
+            vShaderFile.close();
+            fShaderFile.close();
+            // Convert stream into string
+            vertexCode = vShaderStream.str();
+            fragmentCode = fShaderStream.str();
+        }
+        catch (std::ifstream::failure& e) {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        }
+    }
+    insertDefines(vertexCode, defines);
+    insertDefines(fragmentCode, defines);
+    const char* vShaderCode = vertexCode.c_str();
+    const char* fShaderCode = fragmentCode.c_str();
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    unsigned int cachedProgram = loadCachedProgram(vertexCode, fragmentCode);
+    if (cachedProgram) {
+        std::clog << "Shader " << vertexPath << " + " << fragmentPath << ": program binary cache hit, "
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() << " ms" << std::endl;
+        return cachedProgram;
+    }
+
+    // Compile shaders
+    unsigned int vertex, fragment;
+    int success;
+    char infoLog[512];
+
+    // Vertex Shader
+    vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &vShaderCode, NULL);
+    glCompileShader(vertex);
+    // Print compile errors if any
+    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
+            << infoLog << std::endl;
+    }
+
+    // Fragment Shader
+    fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &fShaderCode, NULL);
+    glCompileShader(fragment);
+    // Print compile errors if any
+    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
+            << infoLog << std::endl;
+    }
+
+    // Shader Program
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertex);
+    glAttachShader(shaderProgram, fragment);
+    prepareCachedProgram(shaderProgram);
+    glLinkProgram(shaderProgram);
+    // Print linking errors if any
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+            << infoLog << std::endl;
+    }
+    else {
+        storeCachedProgram(shaderProgram, vertexCode, fragmentCode);
+    }
+    std::clog << "Shader " << vertexPath << " + " << fragmentPath << ": compiled from source, "
+        << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() << " ms" << std::endl;
+    // Delete the shaders as they're linked into our program now and no longer necessary
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    return shaderProgram;
+}
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static bool parallelShaderCompile = false;
+
+bool initParallelShaderCompile(GLADloadproc loadProc) {
+    typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+    MaxShaderCompilerThreadsProc maxShaderCompilerThreads = nullptr;
+    if (hasExtension("GL_KHR_parallel_shader_compile"))
+        maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)loadProc("glMaxShaderCompilerThreadsKHR");
+    else if (hasExtension("GL_ARB_parallel_shader_compile"))
+        maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)loadProc("glMaxShaderCompilerThreadsARB");
+    if (!maxShaderCompilerThreads)
+        return false;
+
+    // 0xFFFFFFFF = as many threads as the implementation likes
+    maxShaderCompilerThreads(0xFFFFFFFF);
+    parallelShaderCompile = true;
+    return true;
+}
+
+// Reads a whole file from disk, bypassing the asset pack
+static bool readSourceFile(const std::string& path, std::string& source) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::stringstream stream;
+    stream << file.rdbuf();
+    source = stream.str();
+    return true;
+}
+
+bool Shader::load(const char* vertexPath, const char* fragmentPath, const std::string& defines) {
+    this->vertexPath = vertexPath;
+    this->fragmentPath = fragmentPath;
+    this->defines = defines;
+    ID = loadShader(vertexPath, fragmentPath, defines);
+
+    int success;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success)
+        return false;
+
+    cacheUniforms();
+    bindUniformBlocks();
+    return true;
+}
+
+void Shader::use() const {
+    glUseProgram(ID);
+}
+
+void Shader::destroy() {
+    glDeleteProgram(ID);
+    ID = 0;
+    uniformLocations.clear();
+    if (pendingID) {
+        glDeleteProgram(pendingID);
+        glDeleteShader(pendingShaders[0]);
+        glDeleteShader(pendingShaders[1]);
+        pendingID = 0;
+    }
+}
+
+bool Shader::usesFile(const std::string& path) const {
+    return path == vertexPath || path == fragmentPath;
+}
+
+void Shader::reload() {
+    std::string sources[2];
+    if (!readSourceFile(vertexPath, sources[0]) || !readSourceFile(fragmentPath, sources[1])) {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        return;
+    }
+    insertDefines(sources[0], defines);
+    insertDefines(sources[1], defines);
+
+    // A newer edit replaces a reload still in flight
+    if (pendingID) {
+        glDeleteProgram(pendingID);
+        glDeleteShader(pendingShaders[0]);
+        glDeleteShader(pendingShaders[1]);
+    }
+
+    // Only issue the work here; no status is queried, so with parallel
+    // compilation the driver finishes it in the background
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    pendingID = glCreateProgram();
+    for (int i = 0; i < 2; ++i) {
+        pendingSources[i] = sources[i];
+        const char* code = pendingSources[i].c_str();
+        pendingShaders[i] = glCreateShader(types[i]);
+        glShaderSource(pendingShaders[i], 1, &code, NULL);
+        glCompileShader(pendingShaders[i]);
+        glAttachShader(pendingID, pendingShaders[i]);
+    }
+    prepareCachedProgram(pendingID);
+    glLinkProgram(pendingID);
+}
+
+bool Shader::pollReload() {
+    if (!pendingID)
+        return false;
+    if (parallelShaderCompile) {
+        int complete = 0;
+        glGetProgramiv(pendingID, GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete)
+            return false;
+    }
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(pendingID, GL_LINK_STATUS, &success);
+    if (!success) {
+        const char* stages[2] = { "VERTEX", "FRAGMENT" };
+        for (int i = 0; i < 2; ++i) {
+            int compiled;
+            glGetShaderiv(pendingShaders[i], GL_COMPILE_STATUS, &compiled);
+            if (!compiled) {
+                glGetShaderInfoLog(pendingShaders[i], 512, NULL, infoLog);
+                std::cerr << "ERROR::SHADER::" << stages[i] << "::COMPILATION_FAILED\n"
+                    << infoLog << std::endl;
+            }
+        }
+        glGetProgramInfoLog(pendingID, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+            << infoLog << std::endl;
+        std::cerr << "Keeping the previous " << vertexPath << " + " << fragmentPath << " program" << std::endl;
+    }
+    else {
+        storeCachedProgram(pendingID, pendingSources[0], pendingSources[1]);
+        glDeleteProgram(ID);
+        ID = pendingID;
+        cacheUniforms();
+        bindUniformBlocks();
+        std::clog << "Reloaded " << vertexPath << " + " << fragmentPath << std::endl;
+    }
+
+    if (!success)
+        glDeleteProgram(pendingID);
+    glDeleteShader(pendingShaders[0]);
+    glDeleteShader(pendingShaders[1]);
+    pendingID = 0;
+    return success != 0;
+}
+
+int Shader::location(const std::string& name) const {
+    auto it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
+}
+
+void Shader::cacheUniforms() {
+    uniformLocations.clear();
+
+    int count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength, '\0');
+    for (int i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, i, maxLength, &length, &size, &type, &name[0]);
+        std::string uniformName(name.c_str(), length);
+
+        // Uniforms inside blocks have no location
+        int location = glGetUniformLocation(ID, uniformName.c_str());
+        if (location < 0)
+            continue;
+        uniformLocations[uniformName] = location;
+
+        // Arrays are reported as "name[0]", also make them reachable as "name"
+        size_t bracket = uniformName.find("[0]");
+        if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+            uniformLocations[uniformName.substr(0, bracket)] = location;
+    }
+}
+
+void Shader::bindUniformBlocks() {
+    int count = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+
+    char name[128];
+    for (int i = 0; i < count; ++i) {
+        glGetActiveUniformBlockName(ID, i, sizeof(name), nullptr, name);
+        int binding = uniformBlockBinding(name);
+        if (binding >= 0)
+            glUniformBlockBinding(ID, i, binding);
+        else
+            std::cerr << "WARNING::SHADER::UNKNOWN_UNIFORM_BLOCK " << name << std::endl;
+    }
+}
+
+template <> void Uniform<int>::set(const int& value) const {
+    glUniform1i(location, value);
+}
+
+template <> void Uniform<float>::set(const float& value) const {
+    glUniform1f(location, value);
+}
+
+template <> void Uniform<glm::vec3>::set(const glm::vec3& value) const {
+    glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+template <> void Uniform<glm::mat3>::set(const glm::mat3& value) const {
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+template <> void Uniform<glm::mat4>::set(const glm::mat4& value) const {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+
+// Compiles and links a vertex + fragment shader pair, returns the program ID.
+// defines ("#define NAME\n" lines) are inserted after the #version line of
+// both stages.
+unsigned int loadShader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "");
+
+// Lets the driver compile and link on its own threads
+// (GL_KHR_parallel_shader_compile or the ARB variant), so a program can be
+// polled for completion instead of stalling the first status query
+bool initParallelShaderCompile(GLADloadproc loadProc);
+
+// Typed handle to a uniform location. Location -1 (inactive or unknown
+// uniform) is ignored by OpenGL, same as with glGetUniformLocation.
+template <typename T>
+struct Uniform {
+    int location = -1;
+    void set(const T& value) const;
+};
+
+template <> void Uniform<int>::set(const int& value) const;
+template <> void Uniform<float>::set(const float& value) const;
+template <> void Uniform<glm::vec3>::set(const glm::vec3& value) const;
+template <> void Uniform<glm::mat3>::set(const glm::mat3& value) const;
+template <> void Uniform<glm::mat4>::set(const glm::mat4& value) const;
+
+// Shader program wrapper. All active uniforms are enumerated once after
+// linking, so looking up a handle never queries the driver and the
+// per-frame path only uses the cached locations. Known uniform blocks are
+// attached to their shared binding points (UniformBuffers.h).
+//
+// reload() recompiles the program from the files on disk (never from the
+// asset pack) without waiting for the result; pollReload() swaps the new
+// program in once it linked, while a broken edit keeps the old one running.
+class Shader {
+public:
+    unsigned int ID = 0;
+
+    bool load(const char* vertexPath, const char* fragmentPath, const std::string& defines = "");
+    void use() const;
+    void destroy();
+
+    bool usesFile(const std::string& path) const;
+    void reload();
+    // True on the frame the new program replaced ID. Uniform handles and
+    // the values of plain uniforms must be set again after that.
+    bool pollReload();
+
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const {
+        Uniform<T> handle;
+        handle.location = location(name);
+        return handle;
+    }
+
+private:
+    int location(const std::string& name) const;
+    void cacheUniforms();
+    void bindUniformBlocks();
+
+    std::unordered_map<std::string, int> uniformLocations;
+
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string defines;
+    unsigned int pendingID = 0;
+    unsigned int pendingShaders[2] = { 0, 0 };
+    std::string pendingSources[2];
+};
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include "SimulationThread.h"
+
+typedef std::chrono::steady_clock Clock;
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start(NBodySystem system, double tickSeconds, int workerThreads, bool threaded) {
+    stop();
+    bodies = std::move(system);
+    tick = tickSeconds;
+    scheduler.reset(new TaskScheduler(workerThreads));
+    lastPositions.clear();
+    ticks = 0;
+    stepNanoseconds = 0;
+    sampleLag = 0.0;
+
+    // The first snapshot has no previous tick, it holds the start twice
+    publish();
+    SimulationPace& initial = pace.back();
+    initial.time = bodies.time;
+    initial.rate = 0.0;
+    initial.wall = Clock::now();
+    pace.publish();
+    stopping = false;
+    if (threaded)
+        worker = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    if (!worker.joinable())
+        return;
+    stopping = true;
+    worker.join();
+}
+
+void SimulationThread::advanceTo(double time, double rate) {
+    if (threaded()) {
+        SimulationPace& target = pace.back();
+        target.time = time;
+        target.rate = rate;
+        target.wall = Clock::now();
+        pace.publish();
+        return;
+    }
+    for (int i = 0; i < MAX_TICKS_PER_ADVANCE; ++i) {
+        int direction = dueDirection(time);
+        if (direction == 0)
+            break;
+        step(direction);
+    }
+}
+
+void SimulationThread::sample(double time, std::vector<glm::vec3>& positions) {
+    snapshots.update();
+    const SimulationSnapshot& snapshot = snapshots.front();
+
+    // One tick back along the direction the simulation last moved
+    double direction = snapshot.time < snapshot.previousTime ? -1.0 : 1.0;
+    double renderTime = time - direction * tick;
+    sampleLag = std::max(0.0, direction * (renderTime - snapshot.time));
+    double span = snapshot.time - snapshot.previousTime;
+    float alpha = 1.0f;
+    if (span != 0.0)
+        alpha = (float)std::min(1.0, std::max(0.0, (renderTime - snapshot.previousTime) / span));
+
+    positions.resize(snapshot.current.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+        positions[i] = snapshot.previous[i] + (snapshot.current[i] - snapshot.previous[i]) * alpha;
+}
+
+double SimulationThread::limitTime(double time) const {
+    // Threaded, the snapshot is up to a frame old even when the simulation
+    // keeps up, so it gets the whole budget as slack
+    double slack = (threaded() ? MAX_TICKS_PER_ADVANCE : 1) * tick;
+    double reached = snapshots.front().time;
+    return std::min(reached + slack, std::max(reached - slack, time));
+}
+
+void SimulationThread::run() {
+    SimulationPace target;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (pace.update())
+            target = pace.front();
+        double elapsed = std::chrono::duration<double>(Clock::now() - target.wall).count();
+        int direction = dueDirection(target.time + target.rate * elapsed);
+        // Ticks are due until the simulation reaches the renderer's clock;
+        // when they take longer than that it simply runs behind
+        if (direction != 0)
+            step(direction);
+        else
+            std::this_thread::sleep_for(std::chrono::duration<double>(0.25 * tick / std::max(1.0, std::abs(target.rate))));
+    }
+}
+
+int SimulationThread::dueDirection(double time) const {
+    if (bodies.time + 0.5 * tick <= time)
+        return 1;
+    if (bodies.time - 0.5 * tick >= time)
+        return -1;
+    return 0;
+}
+
+void SimulationThread::step(int direction) {
+    Clock::time_point begin = Clock::now();
+    stepNBody(bodies, direction * tick, *scheduler);
+    stepNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+    ++ticks;
+    publish();
+}
+
+void SimulationThread::publish() {
+    SimulationSnapshot& snapshot = snapshots.back();
+    snapshot.current.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); ++i)
+        snapshot.current[bodies.id[i]] = glm::vec3(bodies.position[i]);
+    snapshot.time = bodies.time;
+    if (lastPositions.empty()) {
+        snapshot.previous = snapshot.current;
+        snapshot.previousTime = snapshot.time;
+    }
+    else {
+        snapshot.previous = lastPositions;
+        snapshot.previousTime = lastTime;
+    }
+    lastPositions = snapshot.current;
+    lastTime = snapshot.time;
+    snapshots.publish();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "NBody.h"
+#include "TaskScheduler.h"
+#include "TripleBuffer.h"
+
+// Body positions at the last two ticks, indexed by the id the bodies were
+// added to the NBodySystem with
+struct SimulationSnapshot {
+    double previousTime = 0.0;
+    double time = 0.0;
+    std::vector<glm::vec3> previous;
+    std::vector<glm::vec3> current;
+};
+
+// The renderer's clock at a wall-clock instant and its rate, which the
+// simulation thread extrapolates between frames
+struct SimulationPace {
+    double time = 0.0;
+    double rate = 0.0;  // simulated seconds per real second, negative backwards
+    std::chrono::steady_clock::time_point wall;
+};
+
+// Runs an NBodySystem in fixed ticks and hands snapshots to the renderer
+// through a TripleBuffer, so a slow step never holds up a frame and the
+// renderer never blocks the simulation. The renderer draws one tick in the
+// past, interpolating between the snapshot's two states.
+//
+// Time may run either way: leapfrog is time reversible, so going backwards
+// is stepping with -tick. Ticks never grow with the time warp, a faster
+// clock only asks for more of them; past MAX_TICKS_PER_ADVANCE per frame
+// limitTime holds the clock back, so huge warps cost a bounded amount per
+// frame and lose speed instead of accuracy.
+//
+// The renderer sets the time to reach with advanceTo. Threaded, the ticks
+// run on the simulation's own thread, paced by the renderer's clock; when
+// they cost more than real time the simulation falls behind and frames
+// show its newest state instead of waiting. In lockstep (headless and
+// bench runs, so their output never depends on timing) advanceTo runs the
+// due ticks on the calling thread.
+class SimulationThread {
+public:
+    static const int MAX_TICKS_PER_ADVANCE = 1024;
+
+    ~SimulationThread();
+
+    // Takes the system over, its forces must be computed already
+    void start(NBodySystem system, double tickSeconds, int workerThreads, bool threaded);
+    // Joins the thread; the system is then safe to read again
+    void stop();
+
+    // Runs (or lets the thread run) every tick due up to the given time,
+    // rate is how fast the renderer's clock moves on from there
+    void advanceTo(double time, double rate);
+    // Positions at one tick before time, interpolated from the newest snapshot
+    void sample(double time, std::vector<glm::vec3>& positions);
+    // The renderer's time pulled back to where the last sample leaves the
+    // simulation at most MAX_TICKS_PER_ADVANCE ticks (lockstep: one) behind
+    double limitTime(double time) const;
+
+    bool threaded() const { return worker.joinable(); }
+    double tickSeconds() const { return tick; }
+    const NBodySystem& system() const { return bodies; }
+    // Statistics, readable while running
+    long long tickCount() const { return ticks; }
+    double meanStepMilliseconds() const { return ticks > 0 ? stepNanoseconds / 1e6 / ticks : 0.0; }
+    // Simulation time the last sample was missing, in seconds
+    double lag() const { return sampleLag; }
+
+private:
+    void run();
+    // +1 or -1 when a tick towards time is due, 0 when there is none
+    int dueDirection(double time) const;
+    void step(int direction);
+    void publish();
+
+    NBodySystem bodies;
+    std::unique_ptr<TaskScheduler> scheduler;
+    double tick = 1.0 / 240.0;
+    std::vector<glm::vec3> lastPositions;
+    double lastTime = 0.0;
+
+    TripleBuffer<SimulationSnapshot> snapshots;
+    TripleBuffer<SimulationPace> pace;
+    double sampleLag = 0.0;
+
+    std::thread worker;
+    std::atomic<bool> stopping{ false };
+    std::atomic<long long> ticks{ 0 };
+    std::atomic<long long> stepNanoseconds{ 0 };
+};
@@ -0,0 +1,267 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include "MeshOptimization.h"
+#include "SphereMesh.h"
+
+std::vector<float> generateSphereVertices(float radius, int sectorCount, int stackCount) {
+    std::vector<float> vertices;
+    vertices.reserve((stackCount + 1) * (sectorCount + 1) * 8);
+    for (int i = 0; i <= stackCount; ++i) {
+        float theta = i * glm::pi<float>() / stackCount;
+        float sinTheta = sin(theta);
+        float cosTheta = cos(theta);
+
+        for (int j = 0; j <= sectorCount; ++j) {
+            float phi = j * 2 * glm::pi<float>() / sectorCount;
+            float sinPhi = sin(phi);
+            float cosPhi = cos(phi);
+
+            float x = cosPhi * sinTheta;
+            float y = cosTheta;
+            float z = sinPhi * sinTheta;
+            float u = (float)j / sectorCount;
+            float v = (float)i / stackCount;
+
+            // vertex position
+            vertices.push_back(radius * x);
+            vertices.push_back(radius * y);
+            vertices.push_back(radius * z);
+
+            // normal vector
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+
+            // texture coordinates
+            vertices.push_back(u);
+            vertices.push_back(v);
+        }
+    }
+    return vertices;
+}
+
+std::vector<unsigned int> generateSphereIndices(int sectorCount, int stackCount) {
+    std::vector<unsigned int> indices;
+    indices.reserve(stackCount * sectorCount * 6);
+    for (int i = 0; i < stackCount; ++i) {
+        for (int j = 0; j < sectorCount; ++j) {
+            int first = (i * (sectorCount + 1)) + j;
+            int second = first + sectorCount + 1;
+
+            // Counter-clockwise seen from outside. The top and bottom stacks
+            // only get one triangle per sector, the other one would have
+            // two corners on the pole and no area.
+            if (i != 0) {
+                indices.push_back(first);
+                indices.push_back(first + 1);
+                indices.push_back(second);
+            }
+            if (i != stackCount - 1) {
+                indices.push_back(second);
+                indices.push_back(first + 1);
+                indices.push_back(second + 1);
+            }
+        }
+    }
+    return indices;
+}
+
+void generateIcosphere(float radius, int subdivisions, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    // Icosahedron from three orthogonal golden rectangles, faces wound like
+    // the UV sphere (counter-clockwise seen from outside)
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> positions = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+    for (glm::vec3& p : positions)
+        p = glm::normalize(p);
+    std::vector<unsigned int> faces = {
+        0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+        1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+        3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+        4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+    };
+
+    // Split every triangle into four, sharing the new edge midpoints
+    for (int level = 0; level < subdivisions; ++level) {
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            std::pair<unsigned int, unsigned int> key(std::min(a, b), std::max(a, b));
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            positions.push_back(glm::normalize(positions[a] + positions[b]));
+            unsigned int index = (unsigned int)positions.size() - 1;
+            midpoints[key] = index;
+            return index;
+        };
+
+        std::vector<unsigned int> next;
+        next.reserve(faces.size() * 4);
+        for (size_t i = 0; i < faces.size(); i += 3) {
+            unsigned int a = faces[i], b = faces[i + 1], c = faces[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            unsigned int split[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+            next.insert(next.end(), split, split + 12);
+        }
+        faces.swap(next);
+    }
+
+    // Texture coordinates as on the UV sphere: u from the angle around y,
+    // v from the angle to the north pole
+    std::vector<float> us(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        float u = std::atan2(positions[i].z, positions[i].x) / (2.0f * glm::pi<float>());
+        us[i] = u < 0.0f ? u + 1.0f : u;
+    }
+
+    // Vertices are emitted per distinct (position, u) pair
+    std::map<std::pair<unsigned int, float>, unsigned int> emitted;
+    vertices.clear();
+    indices.clear();
+    auto emit = [&](unsigned int index, float u) {
+        auto key = std::make_pair(index, u);
+        auto it = emitted.find(key);
+        if (it != emitted.end())
+            return it->second;
+        const glm::vec3& p = positions[index];
+        float v = std::acos(std::min(std::max(p.y, -1.0f), 1.0f)) / glm::pi<float>();
+        float vertex[8] = { radius * p.x, radius * p.y, radius * p.z, p.x, p.y, p.z, u, v };
+        vertices.insert(vertices.end(), vertex, vertex + 8);
+        unsigned int emittedIndex = (unsigned int)(vertices.size() / 8 - 1);
+        emitted[key] = emittedIndex;
+        return emittedIndex;
+    };
+
+    for (size_t i = 0; i < faces.size(); i += 3) {
+        float u[3];
+        bool pole[3];
+        float minU = 1.0f, maxU = 0.0f;
+        for (int k = 0; k < 3; ++k) {
+            const glm::vec3& p = positions[faces[i + k]];
+            pole[k] = std::fabs(p.x) < 1e-6f && std::fabs(p.z) < 1e-6f;
+            u[k] = us[faces[i + k]];
+            if (!pole[k]) {
+                minU = std::min(minU, u[k]);
+                maxU = std::max(maxU, u[k]);
+            }
+        }
+        // Triangle crossing the seam: continue past u = 1 instead of wrapping
+        if (maxU - minU > 0.5f) {
+            for (int k = 0; k < 3; ++k)
+                if (!pole[k] && u[k] < 0.5f)
+                    u[k] += 1.0f;
+        }
+        // A pole has no meaningful u, give it the one of the opposite edge
+        for (int k = 0; k < 3; ++k) {
+            if (pole[k])
+                u[k] = 0.5f * (u[(k + 1) % 3] + u[(k + 2) % 3]);
+        }
+        for (int k = 0; k < 3; ++k)
+            indices.push_back(emit(faces[i + k], u[k]));
+    }
+}
+
+SphereMeshSet createSphereMeshSet(float radius, SphereType type, const std::vector<int>& detailLevels, VertexFormat format) {
+    SphereMeshSet mesh;
+    mesh.format = format;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for (int detail : detailLevels) {
+        if (type == SPHERE_ICO)
+            detail = std::min(std::max(detail, 0), MAX_ICOSPHERE_SUBDIVISIONS);
+        else
+            detail = std::min(std::max(detail, 2), MAX_UV_STACKS);
+        SphereLOD level;
+        level.detail = detail;
+        level.firstIndex = (int)indices.size();
+        level.baseVertex = (int)(vertices.size() / 8);
+
+        std::vector<float> levelVertices;
+        std::vector<unsigned int> levelIndices;
+        if (type == SPHERE_ICO) {
+            generateIcosphere(radius, detail, levelVertices, levelIndices);
+            // The icosahedron's edges span atan(2), halved by each subdivision
+            level.edgeAngle = std::atan(2.0f) / (float)(1 << detail);
+        }
+        else {
+            levelVertices = generateSphereVertices(radius, detail * 2, detail);
+            levelIndices = generateSphereIndices(detail * 2, detail);
+            level.edgeAngle = 2.0f * glm::pi<float>() / (detail * 2);
+        }
+        level.vertexCount = (int)(levelVertices.size() / 8);
+
+        float acmrBefore = computeACMR(levelIndices, level.vertexCount);
+        optimizeVertexCache(levelIndices, level.vertexCount);
+        optimizeVertexFetch(levelVertices, 8, levelIndices);
+        float acmrAfter = computeACMR(levelIndices, level.vertexCount);
+        std::clog << "Sphere LOD " << mesh.levels.size() << " (" << (type == SPHERE_ICO ? "ico " : "uv ") << detail << "): "
+            << levelIndices.size() / 3 << " triangles, " << level.vertexCount << " vertices, ACMR "
+            << acmrBefore << " -> " << acmrAfter << std::endl;
+
+        vertices.insert(vertices.end(), levelVertices.begin(), levelVertices.end());
+        indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+        level.indexCount = (int)levelIndices.size();
+        mesh.levels.push_back(level);
+    }
+    mesh.vertexCount = (int)(vertices.size() / 8);
+
+    // Indices are relative to each level's baseVertex, so 16 bits suffice
+    // as long as every single level fits
+    bool shortIndices = format == VERTEX_PACKED;
+    for (const SphereLOD& level : mesh.levels)
+        shortIndices = shortIndices && level.vertexCount <= 65536;
+    mesh.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh.indexSize = shortIndices ? sizeof(unsigned short) : sizeof(unsigned int);
+
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    if (format == VERTEX_PACKED) {
+        std::vector<PackedVertex> packed = packVertices(vertices);
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    if (shortIndices) {
+        std::vector<unsigned short> shortIndexData(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndexData.size() * sizeof(unsigned short), shortIndexData.data(), GL_STATIC_DRAW);
+    }
+    else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
+    std::clog << "Sphere mesh: " << vertexStride(format) << " bytes per vertex, " << mesh.indexSize << " bytes per index, "
+        << mesh.vertexCount * vertexStride(format) + indices.size() * mesh.indexSize << " bytes total" << std::endl;
+
+    setVertexAttributes(format);
+    return mesh;
+}
+
+void deleteSphereMeshSet(SphereMeshSet& mesh) {
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh.VAO = mesh.VBO = mesh.EBO = 0;
+    mesh.levels.clear();
+}
+
+int selectSphereLOD(const SphereMeshSet& mesh, float screenRadius, float maxEdgePixels) {
+    // Edges facing the viewer are about r * angle pixels long
+    for (size_t i = 0; i < mesh.levels.size(); ++i) {
+        if (screenRadius * mesh.levels[i].edgeAngle <= maxEdgePixels)
+            return (int)i;
+    }
+    return (int)mesh.levels.size() - 1;
+}
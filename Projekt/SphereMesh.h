@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include "VertexFormat.h"
+
+// UV sphere, y up, u running around the equator. Interleaved position,
+// normal and texture coordinates (8 floats per vertex).
+std::vector<float> generateSphereVertices(float radius, int sectorCount, int stackCount);
+std::vector<unsigned int> generateSphereIndices(int sectorCount, int stackCount);
+
+// Subdivided icosahedron: near-uniform triangles over the whole surface
+// instead of the slivers a UV sphere packs around the poles. Same vertex
+// layout and texture mapping as generateSphereVertices; vertices on the
+// texture seam and at the poles are duplicated so u never wraps inside a
+// triangle.
+void generateIcosphere(float radius, int subdivisions, std::vector<float>& vertices, std::vector<unsigned int>& indices);
+
+enum SphereType {
+    SPHERE_UV,   // detail = stacks, sectors = 2 * stacks
+    SPHERE_ICO   // detail = subdivisions of the icosahedron
+};
+
+// Finest details createSphereMeshSet builds, finer requests are clamped:
+// 327680 triangles for the icosphere, 1048576 for the UV sphere
+const int MAX_ICOSPHERE_SUBDIVISIONS = 7;
+const int MAX_UV_STACKS = 512;
+
+// One level of detail inside the shared sphere buffers
+struct SphereLOD {
+    int detail;
+    float edgeAngle;  // angle one equator edge spans, in radians
+    int firstIndex;
+    int indexCount;
+    int baseVertex;
+    int vertexCount;
+};
+
+// Every LOD of the sphere in one VAO (attributes 0-2), ordered from the
+// coarsest to the finest level. Levels are drawn with
+// glDrawElementsInstancedBaseVertex using firstIndex/baseVertex; the
+// element offset is firstIndex * indexSize.
+struct SphereMeshSet {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    int vertexCount = 0;
+    VertexFormat format = VERTEX_FLOAT;
+    unsigned int indexType = 0;  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    int indexSize = 0;
+    std::vector<SphereLOD> levels;
+};
+
+// Builds one level per detail value, clamped to the limits above
+// (and at least 2 stacks for UV spheres). Triangles of every level are ordered
+// for the post-transform vertex cache (MeshOptimization.h), and the
+// resulting ACMR is logged. Packed meshes also use 16-bit indices when
+// no level has more than 65536 vertices.
+SphereMeshSet createSphereMeshSet(float radius, SphereType type, const std::vector<int>& detailLevels, VertexFormat format = VERTEX_FLOAT);
+void deleteSphereMeshSet(SphereMeshSet& mesh);
+
+// Coarsest level whose facets stay within maxEdgePixels on screen for a
+// sphere of the given projected radius in pixels
+int selectSphereLOD(const SphereMeshSet& mesh, float screenRadius, float maxEdgePixels = 8.0f);
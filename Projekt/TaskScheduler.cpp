@@ -0,0 +1,108 @@
+#include <algorithm>
+#include "TaskScheduler.h"
+
+TaskScheduler::TaskScheduler(int threadCount) {
+    if (threadCount <= 0)
+        threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int i = 0; i < threadCount; ++i)
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    for (int i = 1; i < threadCount; ++i)
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void TaskScheduler::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function) {
+    grainSize = std::max<size_t>(1, grainSize);
+    if (count <= grainSize || workers.empty()) {
+        for (size_t begin = 0; begin < count; begin += grainSize)
+            function(begin, std::min(count, begin + grainSize));
+        return;
+    }
+
+    body = &function;
+    grain = grainSize;
+    remaining.store(count, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(queues[0]->mutex);
+        queues[0]->ranges.push_back({ 0, count });
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    // The caller works too, until the last range has finished anywhere
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!runOne(0))
+            std::this_thread::yield();
+    }
+}
+
+void TaskScheduler::workerLoop(int index) {
+    unsigned int seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!runOne(index))
+                std::this_thread::yield();
+        }
+    }
+}
+
+bool TaskScheduler::runOne(int index) {
+    Range range;
+    bool found = false;
+    {
+        WorkQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.back();
+            own.ranges.pop_back();
+            found = true;
+        }
+    }
+    // Steal the oldest (largest) range, trying the neighbours in turn
+    const int count = (int)queues.size();
+    for (int k = 1; k < count && !found; ++k) {
+        WorkQueue& victim = *queues[(index + k) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            found = true;
+            ++steals;
+        }
+    }
+    if (!found)
+        return false;
+
+    // Keep halving, leaving the upper halves for this thread or thieves
+    while (range.end - range.begin > grain) {
+        size_t middle = range.begin + (range.end - range.begin) / 2;
+        {
+            WorkQueue& own = *queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.ranges.push_back({ middle, range.end });
+        }
+        range.end = middle;
+    }
+    (*body)(range.begin, range.end);
+    remaining.fetch_sub(range.end - range.begin, std::memory_order_acq_rel);
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for data-parallel loops. parallelFor hands the whole
+// index range to the calling thread's queue; whoever runs a range splits it
+// in half, keeps the lower half and pushes the upper one onto its own queue
+// (lazy binary splitting). Owners pop their newest, smallest ranges while
+// idle threads steal the oldest, largest ones from the others, so uneven
+// work (dense tree regions) balances itself without a central queue.
+class TaskScheduler {
+public:
+    // 0 threads = one per core; the calling thread is one of them
+    explicit TaskScheduler(int threadCount = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Calls body(begin, end) on disjoint chunks of at most grain indices
+    // covering [0, count) and returns once all of them are done. Ranges of
+    // up to grain indices run inline without waking the workers. Not
+    // reentrant: body must not call parallelFor itself.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    int threadCount() const { return (int)queues.size(); }
+    // Ranges taken from another thread's queue since construction
+    size_t stealCount() const { return steals; }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void workerLoop(int index);
+    // Runs one range from the own queue or a stolen one, false when there
+    // was nothing to take
+    bool runOne(int index);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;  // 0 belongs to the caller
+    std::vector<std::thread> workers;
+
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    size_t grain = 1;
+    std::atomic<size_t> remaining{ 0 };
+    std::atomic<size_t> steals{ 0 };
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    unsigned int generation = 0;
+    bool stopping = false;
+};
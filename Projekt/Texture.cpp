@@ -0,0 +1,295 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "AssetPack.h"
+#include "GLExtensions.h"
+#include "Texture.h"
+#include "TextureCompression.h"
+
+TextureArrayLoader::~TextureArrayLoader() {
+    // Never leave workers running on destruction; skip what is left
+    nextLayer = layerCount;
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+unsigned int TextureArrayLoader::start(const std::vector<const char*>& imagePaths, int threadCount, bool allowCompression) {
+    startTime = std::chrono::steady_clock::now();
+    paths.assign(imagePaths.begin(), imagePaths.end());
+    layerCount = (int)paths.size();
+
+    // Read only the headers first to size the array
+    for (const std::string& path : paths) {
+        int w, h, nrComponents;
+        size_t packedSize = 0;
+        const unsigned char* packed = findAsset(path, packedSize);
+        int found = packed ? stbi_info_from_memory(packed, (int)packedSize, &w, &h, &nrComponents)
+            : stbi_info(path.c_str(), &w, &h, &nrComponents);
+        if (found) {
+            width = std::max(width, w);
+            height = std::max(height, h);
+        }
+    }
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    if (width == 0) {
+        std::cout << "Failed to load any texture array layer" << std::endl;
+        uploadedLayers = layerCount;
+        return textureID;
+    }
+
+    compressed = allowCompression && hasExtension("GL_EXT_texture_compression_s3tc");
+    if (compressed) {
+        // Every level exists from the start, filled with grey BC1 blocks
+        mipLevels = mipLevelCount(width, height);
+        const unsigned char greyBlock[8] = { 0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0 };
+        std::vector<unsigned char> placeholder(bc1LevelSize(width, height) * layerCount);
+        for (size_t i = 0; i < placeholder.size(); ++i)
+            placeholder[i] = greyBlock[i % 8];
+
+        int w = width, h = height;
+        for (int level = 0; level < mipLevels; ++level) {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, w, h, layerCount, 0,
+                (GLsizei)(bc1LevelSize(w, h) * layerCount), placeholder.data());
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    else {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        // Grey placeholder in every layer; there are no mipmaps yet, so sample
+        // the base level only until everything is loaded
+        std::vector<unsigned char> placeholder(width * height * 4, 128);
+        for (int layer = 0; layer < layerCount; ++layer)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholder.data());
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (threadCount <= 0)
+        threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    threads = std::min(threadCount, layerCount);
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back(&TextureArrayLoader::decodeLayers, this);
+
+    return textureID;
+}
+
+bool TextureArrayLoader::decodeImage(int layer, std::vector<unsigned char>& rgba) {
+    int w, h, nrComponents;
+    size_t packedSize = 0;
+    const unsigned char* packed = findAsset(paths[layer], packedSize);
+    unsigned char* data = packed ? stbi_load_from_memory(packed, (int)packedSize, &w, &h, &nrComponents, 4)
+        : stbi_load(paths[layer].c_str(), &w, &h, &nrComponents, 4);
+    if (!data)
+        return false;
+    if (w == width && h == height)
+        rgba.assign(data, data + w * h * 4);
+    else
+        rgba = resampleImage(data, w, h, 4, width, height);
+    stbi_image_free(data);
+    return true;
+}
+
+void TextureArrayLoader::decodeLayers() {
+    for (int layer = nextLayer++; layer < layerCount; layer = nextLayer++) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        DecodedLayer decoded;
+        decoded.layer = layer;
+        if (compressed) {
+            std::string cachePath = compressedCachePath(paths[layer]);
+            size_t packedSize = 0;
+            const unsigned char* packed = findAsset(cachePath, packedSize);
+            // The pack is built from the caches, so a packed .dds is never stale
+            if (packed && (decoded.mapped = parseBC1DDS(packed, packedSize, width, height, mipLevels))) {
+                ++cacheHits;
+            }
+            else if (compressedCacheIsFresh(paths[layer], cachePath) && readBC1DDS(cachePath, width, height, mipLevels, decoded.pixels)) {
+                ++cacheHits;
+            }
+            else {
+                // First run (or changed source): compress and write the cache
+                std::vector<unsigned char> rgba;
+                decoded.pixels.clear();
+                if (decodeImage(layer, rgba)) {
+                    decoded.pixels = compressBC1MipChain(rgba.data(), width, height);
+                    if (!writeBC1DDS(cachePath, width, height, mipLevels, decoded.pixels))
+                        std::cerr << "WARNING::TEXTURE::CANNOT_WRITE_CACHE " << cachePath << std::endl;
+                }
+            }
+        }
+        else {
+            decodeImage(layer, decoded.pixels);
+        }
+
+        decodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready.push_back(std::move(decoded));
+        readyCondition.notify_one();
+    }
+}
+
+bool TextureArrayLoader::poll() {
+    if (done())
+        return true;
+
+    std::vector<DecodedLayer> finished;
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        finished.swap(ready);
+    }
+    for (const DecodedLayer& decoded : finished)
+        upload(decoded);
+
+    if (done())
+        complete();
+    return done();
+}
+
+void TextureArrayLoader::finish() {
+    while (!done()) {
+        std::vector<DecodedLayer> finished;
+        {
+            std::unique_lock<std::mutex> lock(readyMutex);
+            readyCondition.wait(lock, [this] { return !ready.empty(); });
+            finished.swap(ready);
+        }
+        for (const DecodedLayer& decoded : finished)
+            upload(decoded);
+        if (done())
+            complete();
+    }
+}
+
+void TextureArrayLoader::upload(const DecodedLayer& decoded) {
+    if (!decoded.mapped && decoded.pixels.empty()) {
+        std::cout << "Failed to load texture: " << paths[decoded.layer] << std::endl;
+    }
+    else if (compressed) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+        const unsigned char* levelData = decoded.mapped ? decoded.mapped : decoded.pixels.data();
+        int w = width, h = height;
+        for (int level = 0; level < mipLevels; ++level) {
+            size_t size = bc1LevelSize(w, h);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, decoded.layer, w, h, 1,
+                GL_COMPRESSED_RGB_S3TC_DXT1_EXT, (GLsizei)size, levelData);
+            levelData += size;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, decoded.layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, decoded.pixels.data());
+    }
+    ++uploadedLayers;
+}
+
+void TextureArrayLoader::complete() {
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+
+    // Compressed layers come with their mip chain
+    if (!compressed) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+
+    elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::clog << "Loaded " << layerCount << " textures in " << elapsedMs << " ms ("
+        << threads << " decode threads, " << decodeMicroseconds / 1000.0 << " ms decode time in total)" << std::endl;
+    std::clog << "Texture array: " << (compressed ? "BC1" : "RGBA8") << ", "
+        << memoryBytes() / (1024.0 * 1024.0) << " MB";
+    if (compressed)
+        std::clog << ", " << cacheHits << "/" << layerCount << " layers from the .dds cache";
+    std::clog << std::endl;
+}
+
+size_t TextureArrayLoader::memoryBytes() const {
+    size_t bytes = 0;
+    int w = width, h = height;
+    int levels = mipLevelCount(width, height);
+    for (int level = 0; level < levels; ++level) {
+        bytes += compressed ? bc1LevelSize(w, h) : (size_t)w * h * 4;
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    return bytes * layerCount;
+}
+
+// Filter taps of one destination pixel along one axis
+struct ResampleTaps {
+    int first;
+    std::vector<float> weights;
+};
+
+static std::vector<ResampleTaps> computeTaps(int srcSize, int dstSize) {
+    std::vector<ResampleTaps> taps(dstSize);
+    float scale = (float)srcSize / dstSize;
+    float support = std::max(scale, 1.0f);
+    for (int i = 0; i < dstSize; ++i) {
+        float center = (i + 0.5f) * scale - 0.5f;
+        int first = (int)std::floor(center - support) + 1;
+        int last = (int)std::ceil(center + support) - 1;
+        float sum = 0.0f;
+        taps[i].first = first;
+        for (int x = first; x <= last; ++x) {
+            float w = std::max(0.0f, 1.0f - std::fabs(x - center) / support);
+            taps[i].weights.push_back(w);
+            sum += w;
+        }
+        for (float& w : taps[i].weights)
+            w /= sum;
+    }
+    return taps;
+}
+
+std::vector<unsigned char> resampleImage(const unsigned char* src, int srcWidth, int srcHeight,
+    int channels, int dstWidth, int dstHeight) {
+    std::vector<ResampleTaps> xTaps = computeTaps(srcWidth, dstWidth);
+    std::vector<ResampleTaps> yTaps = computeTaps(srcHeight, dstHeight);
+
+    // Horizontal pass into a float buffer, then vertical pass into bytes
+    std::vector<float> rows(dstWidth * srcHeight * channels);
+    for (int y = 0; y < srcHeight; ++y) {
+        const unsigned char* srcRow = src + y * srcWidth * channels;
+        for (int x = 0; x < dstWidth; ++x) {
+            float* out = &rows[(y * dstWidth + x) * channels];
+            const ResampleTaps& t = xTaps[x];
+            for (size_t k = 0; k < t.weights.size(); ++k) {
+                int sx = std::min(std::max(t.first + (int)k, 0), srcWidth - 1);
+                for (int c = 0; c < channels; ++c)
+                    out[c] += t.weights[k] * srcRow[sx * channels + c];
+            }
+        }
+    }
+
+    std::vector<unsigned char> dst(dstWidth * dstHeight * channels);
+    std::vector<float> accum(dstWidth * channels);
+    for (int y = 0; y < dstHeight; ++y) {
+        std::fill(accum.begin(), accum.end(), 0.0f);
+        const ResampleTaps& t = yTaps[y];
+        for (size_t k = 0; k < t.weights.size(); ++k) {
+            int sy = std::min(std::max(t.first + (int)k, 0), srcHeight - 1);
+            const float* row = &rows[sy * dstWidth * channels];
+            for (int i = 0; i < dstWidth * channels; ++i)
+                accum[i] += t.weights[k] * row[i];
+        }
+        for (int i = 0; i < dstWidth * channels; ++i)
+            dst[y * dstWidth * channels + i] = (unsigned char)std::min(std::max(accum[i] + 0.5f, 0.0f), 255.0f);
+    }
+    return dst;
+}
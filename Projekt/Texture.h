@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads images into the layers of one mipmapped RGBA8 GL_TEXTURE_2D_ARRAY,
+// so every body can be drawn with a single texture binding and a per-draw
+// (or per-instance) layer index. The array takes the largest width and
+// height among the images; smaller or differently shaped ones are resampled.
+//
+// Images are decoded (and resampled) concurrently on worker threads while
+// the GL thread keeps rendering; poll() uploads the layers finished so far,
+// finish() blocks until all of them are in. Until a layer
+// arrives it shows a grey placeholder, and mipmaps are generated once the
+// last layer is in.
+//
+// When the driver supports S3TC, layers are stored BC1 compressed instead:
+// the first run compresses every image with its full mip chain and caches
+// it as a .dds file next to the source, later runs only read those files
+// and upload them with glCompressedTexSubImage3D.
+//
+// Images and .dds files found in the mounted asset pack are decoded from
+// (or uploaded directly out of) the memory mapping instead of the files.
+class TextureArrayLoader {
+public:
+    ~TextureArrayLoader();
+
+    // Allocates the array and starts the workers (0 threads = one per core).
+    // Must be called on the GL thread; returns the texture ID immediately.
+    unsigned int start(const std::vector<const char*>& paths, int threadCount = 0, bool allowCompression = true);
+    // Uploads finished layers, returns true once every layer is resident
+    bool poll();
+    // Waits for and uploads all remaining layers
+    void finish();
+
+    bool done() const { return uploadedLayers == layerCount; }
+    // Time from start() until the last layer was uploaded
+    double elapsedMilliseconds() const { return elapsedMs; }
+    // Video memory taken by the array including mipmaps
+    size_t memoryBytes() const;
+
+private:
+    struct DecodedLayer {
+        int layer;
+        std::vector<unsigned char> pixels;
+        // Set instead of pixels when the data is uploaded straight from the asset pack
+        const unsigned char* mapped = nullptr;
+    };
+
+    void decodeLayers();
+    bool decodeImage(int layer, std::vector<unsigned char>& rgba);
+    void upload(const DecodedLayer& decoded);
+    void complete();
+
+    std::vector<std::string> paths;
+    unsigned int textureID = 0;
+    int width = 0;
+    int height = 0;
+    int layerCount = 0;
+    int uploadedLayers = 0;
+    int threads = 0;
+    bool compressed = false;
+    int mipLevels = 1;
+
+    std::atomic<int> nextLayer{ 0 };
+    std::atomic<long long> decodeMicroseconds{ 0 };
+    std::atomic<int> cacheHits{ 0 };
+    std::vector<std::thread> workers;
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    std::vector<DecodedLayer> ready;
+
+    std::chrono::steady_clock::time_point startTime;
+    double elapsedMs = 0.0;
+};
+
+// Resamples an 8-bit image with a tent filter (bilinear when enlarging,
+// area-weighted when shrinking)
+std::vector<unsigned char> resampleImage(const unsigned char* src, int srcWidth, int srcHeight,
+    int channels, int dstWidth, int dstHeight);
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "Texture.h"
+#include "TextureCompression.h"
+
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        ++levels;
+    }
+    return levels;
+}
+
+size_t bc1LevelSize(int width, int height) {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+static uint16_t packRGB565(const float color[3]) {
+    int r = (int)std::lround(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+    int g = (int)std::lround(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+    int b = (int)std::lround(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(uint16_t packed, float color[3]) {
+    color[0] = ((packed >> 11) & 31) * 255.0f / 31.0f;
+    color[1] = ((packed >> 5) & 63) * 255.0f / 63.0f;
+    color[2] = (packed & 31) * 255.0f / 31.0f;
+}
+
+// Fits the two endpoints along the principal axis of the block colours
+static void compressBlockBC1(const unsigned char block[16][4], unsigned char* out) {
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += block[i][c] / 16.0f;
+
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        float d[3] = { block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2] };
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    // Power iteration for the dominant eigenvector
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]
+        };
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 3; ++c)
+            axis[c] = next[c] / length;
+    }
+
+    float minProj = 1e30f, maxProj = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float proj = 0.0f;
+        for (int c = 0; c < 3; ++c)
+            proj += (block[i][c] - mean[c]) * axis[c];
+        minProj = std::min(minProj, proj);
+        maxProj = std::max(maxProj, proj);
+    }
+
+    float endMax[3], endMin[3];
+    for (int c = 0; c < 3; ++c) {
+        endMax[c] = mean[c] + axis[c] * maxProj;
+        endMin[c] = mean[c] + axis[c] * minProj;
+    }
+    uint16_t color0 = packRGB565(endMax);
+    uint16_t color1 = packRGB565(endMin);
+    // color0 > color1 selects the 4-colour mode
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        float palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestError = 1e30f;
+            for (int p = 0; p < 4; ++p) {
+                float error = 0.0f;
+                for (int c = 0; c < 3; ++c) {
+                    float d = block[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+std::vector<unsigned char> compressBC1(const unsigned char* rgba, int width, int height) {
+    std::vector<unsigned char> blocks(bc1LevelSize(width, height));
+    unsigned char* out = blocks.data();
+    unsigned char block[16][4];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            // Edge blocks of small mip levels repeat the last row/column
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx + x, width - 1);
+                    int sy = std::min(by + y, height - 1);
+                    const unsigned char* pixel = rgba + (sy * width + sx) * 4;
+                    for (int c = 0; c < 4; ++c)
+                        block[y * 4 + x][c] = pixel[c];
+                }
+            }
+            compressBlockBC1(block, out);
+            out += 8;
+        }
+    }
+    return blocks;
+}
+
+std::vector<unsigned char> compressBC1MipChain(const unsigned char* rgba, int width, int height) {
+    std::vector<unsigned char> chain = compressBC1(rgba, width, height);
+
+    std::vector<unsigned char> level;
+    const unsigned char* previous = rgba;
+    while (width > 1 || height > 1) {
+        int nextWidth = std::max(1, width / 2);
+        int nextHeight = std::max(1, height / 2);
+        level = resampleImage(previous, width, height, 4, nextWidth, nextHeight);
+        std::vector<unsigned char> blocks = compressBC1(level.data(), nextWidth, nextHeight);
+        chain.insert(chain.end(), blocks.begin(), blocks.end());
+
+        previous = level.data();
+        width = nextWidth;
+        height = nextHeight;
+    }
+    return chain;
+}
+
+// DDS layout: "DDS " magic followed by a 124 byte header of 31 dwords
+static const uint32_t DDS_MAGIC = 0x20534444;        // "DDS "
+static const uint32_t DDS_FOURCC_DXT1 = 0x31545844;  // "DXT1"
+
+static size_t bc1ChainSize(int width, int height, int mipLevels) {
+    size_t size = 0;
+    for (int level = 0; level < mipLevels; ++level) {
+        size += bc1LevelSize(width, height);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return size;
+}
+
+static bool checkBC1Header(uint32_t magic, const uint32_t header[31], int width, int height, int mipLevels) {
+    if (magic != DDS_MAGIC || header[0] != 124)
+        return false;
+    int fileMipLevels = header[6] ? (int)header[6] : 1;
+    return (int)header[3] == width && (int)header[2] == height && fileMipLevels == mipLevels && header[20] == DDS_FOURCC_DXT1;
+}
+
+bool readBC1DDS(const std::string& path, int width, int height, int mipLevels, std::vector<unsigned char>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t magic = 0;
+    uint32_t header[31];
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)header, sizeof(header));
+    if (!file || !checkBC1Header(magic, header, width, height, mipLevels))
+        return false;
+
+    data.resize(bc1ChainSize(width, height, mipLevels));
+    file.read((char*)data.data(), data.size());
+    return (bool)file;
+}
+
+const unsigned char* parseBC1DDS(const unsigned char* file, size_t size, int width, int height, int mipLevels) {
+    uint32_t magic = 0;
+    uint32_t header[31];
+    const size_t headerSize = sizeof(magic) + sizeof(header);
+    if (size < headerSize)
+        return nullptr;
+    memcpy(&magic, file, sizeof(magic));
+    memcpy(header, file + sizeof(magic), sizeof(header));
+    if (!checkBC1Header(magic, header, width, height, mipLevels) || size < headerSize + bc1ChainSize(width, height, mipLevels))
+        return nullptr;
+    return file + headerSize;
+}
+
+bool writeBC1DDS(const std::string& path, int width, int height, int mipLevels, const std::vector<unsigned char>& data) {
+    uint32_t header[31] = {};
+    header[0] = 124;
+    header[1] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;  // CAPS|HEIGHT|WIDTH|PIXELFORMAT|MIPMAPCOUNT|LINEARSIZE
+    header[2] = height;
+    header[3] = width;
+    header[4] = (uint32_t)bc1LevelSize(width, height);
+    header[6] = mipLevels;
+    header[18] = 32;    // pixel format size
+    header[19] = 0x4;   // DDPF_FOURCC
+    header[20] = DDS_FOURCC_DXT1;
+    header[26] = 0x8 | 0x1000 | 0x400000;  // COMPLEX|TEXTURE|MIPMAP
+
+    // Write to a temporary file first so a crash never leaves a truncated cache
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file)
+            return false;
+        file.write((const char*)&DDS_MAGIC, sizeof(DDS_MAGIC));
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)data.data(), data.size());
+        if (!file)
+            return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+std::string compressedCachePath(const std::string& sourcePath) {
+    return std::filesystem::path(sourcePath).replace_extension(".dds").string();
+}
+
+bool compressedCacheIsFresh(const std::string& sourcePath, const std::string& cachePath) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+    if (error)
+        return false;
+    auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    return !error && cacheTime >= sourceTime;
+}
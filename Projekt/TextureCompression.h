@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// BC1 (DXT1) block compression and a minimal DDS reader/writer, used to
+// cache pre-mipmapped GPU-compressed copies of the textures on disk.
+// BC1 stores 4x4 pixels in 8 bytes (RGB, alpha dropped): 8x smaller than
+// RGBA8 both on disk and in video memory.
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+// Number of levels in a full mip chain down to 1x1
+int mipLevelCount(int width, int height);
+
+// Byte size of one BC1 compressed level
+size_t bc1LevelSize(int width, int height);
+
+// Compresses an RGBA8 image into BC1 blocks
+std::vector<unsigned char> compressBC1(const unsigned char* rgba, int width, int height);
+
+// Builds the full mip chain of an RGBA8 image and compresses every level,
+// levels are stored one after another starting with the largest
+std::vector<unsigned char> compressBC1MipChain(const unsigned char* rgba, int width, int height);
+
+// Reads a BC1 DDS file with exactly the expected size and mip count
+bool readBC1DDS(const std::string& path, int width, int height, int mipLevels, std::vector<unsigned char>& data);
+bool writeBC1DDS(const std::string& path, int width, int height, int mipLevels, const std::vector<unsigned char>& data);
+
+// Same check for a DDS file already in memory (e.g. inside the asset pack);
+// returns the start of its mip chain in that buffer, nullptr on mismatch
+const unsigned char* parseBC1DDS(const unsigned char* file, size_t size, int width, int height, int mipLevels);
+
+// Cache file of a source image: "textures/earth.jpg" -> "textures/earth.dds"
+std::string compressedCachePath(const std::string& sourcePath);
+
+// True when the cache file exists and is not older than the source image
+bool compressedCacheIsFresh(const std::string& sourcePath, const std::string& cachePath);
@@ -0,0 +1,167 @@
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include "Belt.h"
+#include "NBody.h"
+#include "OrbitSimulation.h"
+#include "SimulationThread.h"
+#include "TimeWarp.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void TimeWarp::set(double rate) {
+    paused = rate == 0.0;
+    reversed = rate < 0.0;
+    if (!paused)
+        factor = std::min(std::max(std::abs(rate), 1.0), MAX_TIME_WARP);
+}
+
+void TimeWarp::faster() {
+    factor = std::min(factor * 10.0, MAX_TIME_WARP);
+}
+
+void TimeWarp::slower() {
+    factor = std::max(factor / 10.0, 1.0);
+}
+
+std::string TimeWarp::label() const {
+    if (paused)
+        return "paused";
+    std::ostringstream out;
+    out << rate() << "x";
+    return out.str();
+}
+
+// Difference of two angles, wrapped to [-pi, pi]
+static double angleError(double a, double b) {
+    const double twoPi = 2.0 * glm::pi<double>();
+    double d = a - b;
+    return std::abs(d - twoPi * std::floor(d / twoPi + 0.5));
+}
+
+void benchmarkTimeWarp(const Scene& scene, int simThreads) {
+    const int frames = 240;
+    const double frameSeconds = 1.0 / 60.0;
+    const double tick = 1.0 / 240.0;
+    const double levels[] = { 0.0, 1.0, 10.0, 100.0, 1e3, 1e4, 1e5, 1e6, 1e7, -1e7 };
+
+    OrbitState orbits = createOrbitState(scene);
+    std::vector<double> masses;
+    for (const SceneBody& body : scene.bodies)
+        masses.push_back(body.mass);
+    std::vector<BeltInstance> beltStart;
+    for (const SceneBelt& belt : scene.belts) {
+        std::vector<BeltInstance> instances = generateBelt(belt, 1.0f);
+        beltStart.insert(beltStart.end(), instances.begin(), instances.end());
+    }
+
+    std::cout << "{\n  \"time_warp\": {\n    \"frames\": " << frames
+        << ",\n    \"frame_seconds\": " << frameSeconds
+        << ",\n    \"tick_seconds\": " << tick
+        << ",\n    \"bodies\": " << orbits.size()
+        << ",\n    \"belt_bodies\": " << beltStart.size()
+        << ",\n    \"levels\": [\n";
+    const size_t levelCount = sizeof(levels) / sizeof(levels[0]);
+    for (size_t n = 0; n < levelCount; ++n) {
+        TimeWarp warp;
+        warp.set(levels[n]);
+        const double rate = warp.rate();
+
+        // Orbits: closed form, the cost does not depend on the warp
+        std::vector<PlanetInstance> instances(orbits.size()), reference(orbits.size());
+        double time = 0.0;
+        double orbitMs = 0.0;
+        for (int frame = 0; frame < frames; ++frame) {
+            time += frameSeconds * rate;
+            Clock::time_point start = Clock::now();
+            updateOrbits(orbits, time, instances.data());
+            applyHierarchy(orbits, instances.data());
+            orbitMs += millisecondsSince(start);
+        }
+        // Against the double precision reference, relative to orbit size
+        updateOrbits(orbits, time, instances.data());
+        updateOrbitsScalar(orbits, time, reference.data());
+        float orbitError = 0.0f;
+        for (size_t i = 0; i < orbits.size(); ++i) {
+            float axis = glm::length(glm::vec3(orbits.px[i], orbits.py[i], orbits.pz[i]));
+            if (axis > 0.0f)
+                orbitError = std::max(orbitError, glm::length(glm::vec3(instances[i].model[3]) - glm::vec3(reference[i].model[3])) / axis);
+        }
+
+        // Belts: the phases the shader sees, rebased as the renderer does
+        std::vector<BeltInstance> belt = beltStart;
+        double epoch = 0.0;
+        int rebases = 0;
+        double beltMs = 0.0;
+        time = 0.0;
+        for (int frame = 0; frame < frames; ++frame) {
+            time += frameSeconds * rate;
+            if (std::abs(time - epoch) > BELT_EPOCH_SPAN) {
+                Clock::time_point start = Clock::now();
+                advanceBeltPhases(belt, time - epoch);
+                beltMs += millisecondsSince(start);
+                epoch = time;
+                ++rebases;
+            }
+        }
+        // Angles as the float shader computes them, with and without the
+        // epoch, against the exact one
+        double beltError = 0.0, unrebasedError = 0.0;
+        for (size_t i = 0; i < belt.size(); i += 97) {
+            float speed = belt[i].orbit.z;
+            double exact = beltStart[i].orbit.y + (double)speed * time;
+            float shader = belt[i].orbit.y + speed * (float)(time - epoch);
+            float unrebased = beltStart[i].orbit.y + speed * (float)time;
+            beltError = std::max(beltError, angleError(shader, exact));
+            unrebasedError = std::max(unrebasedError, angleError(unrebased, exact));
+        }
+
+        // N-body: fixed ticks, as many as the warp asks for up to the
+        // per-frame budget
+        NBodySystem system = createNBodySystem(orbits, masses, scene.gravitationalConstant, 0.0);
+        system.softening = 0.01;
+        TaskScheduler initialForces(1);
+        computeForces(system, initialForces);
+        double startEnergy = totalEnergy(system);
+        SimulationThread simulation;
+        simulation.start(std::move(system), tick, simThreads, false);
+        std::vector<glm::vec3> positions;
+        std::vector<double> frameMs;
+        time = 0.0;
+        for (int frame = 0; frame < frames; ++frame) {
+            time += frameSeconds * rate;
+            Clock::time_point start = Clock::now();
+            simulation.advanceTo(time, rate);
+            simulation.sample(time, positions);
+            time = simulation.limitTime(time);
+            frameMs.push_back(millisecondsSince(start));
+        }
+        std::sort(frameMs.begin(), frameMs.end());
+        const NBodySystem& result = simulation.system();
+        double achieved = result.time / (frames * frameSeconds);
+
+        std::cout << "      { \"warp\": " << rate
+            << ", \"simulated_seconds\": " << frames * frameSeconds * rate
+            << ", \"orbit_ms\": " << orbitMs / frames
+            << ", \"orbit_max_relative_error\": " << orbitError
+            << ", \"belt_rebases\": " << rebases
+            << ", \"belt_rebase_ms\": " << (rebases > 0 ? beltMs / rebases : 0.0)
+            << ", \"belt_max_angle_error\": " << beltError
+            << ", \"belt_unrebased_angle_error\": " << unrebasedError
+            << ", \"nbody_ticks_per_frame\": " << (double)simulation.tickCount() / frames
+            << ", \"nbody_frame_ms\": " << frameMs[frameMs.size() / 2]
+            << ", \"nbody_step_ms\": " << simulation.meanStepMilliseconds()
+            << ", \"nbody_achieved_warp\": " << achieved
+            << ", \"nbody_simulated_per_second\": " << (result.time != 0.0 ? std::abs(result.time) / (simulation.tickCount() * simulation.meanStepMilliseconds() / 1000.0) : 0.0)
+            << ", \"nbody_energy_drift\": " << energyDrift(startEnergy, totalEnergy(result)) << " }"
+            << (n + 1 < levelCount ? ",\n" : "\n");
+    }
+    std::cout << "    ]\n  }\n}\n";
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include "Scene.h"
+
+const double MAX_TIME_WARP = 1e7;
+
+// How fast simulated time runs against real time: paused, or 1x to 10^7x
+// forwards or backwards, changed in decades at runtime. Everything that
+// moves is either closed form (orbits, belts) or sub-stepped at a fixed
+// tick (N-body), so the warp only changes which time gets evaluated, never
+// the size of a step.
+struct TimeWarp {
+    double factor = 1.0;  // 1 to MAX_TIME_WARP
+    bool reversed = false;
+    bool paused = false;
+
+    // Simulated seconds per real second
+    double rate() const { return paused ? 0.0 : (reversed ? -factor : factor); }
+    // From a rate: 0 pauses, negative runs backwards
+    void set(double rate);
+    void faster();
+    void slower();
+    // "paused", "1000x", "-10x"
+    std::string label() const;
+};
+
+// Plays 240 frames of the scene at each warp level, pause and reverse
+// included, and prints per-frame cost and accuracy of the orbit, belt and
+// N-body updates as JSON
+void benchmarkTimeWarp(const Scene& scene, int simThreads);
@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+
+// Lock-free single producer, single consumer handoff of the latest value.
+// The producer fills back() and publishes it, which swaps it with the
+// middle slot; the consumer swaps the middle slot with front() whenever a
+// fresh one is waiting. Neither side ever waits for the other, and the
+// consumer always gets the newest complete value (older ones are skipped).
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer side
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Consumer side: true when a newer value was swapped into front()
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    int backIndex = 0;                // only touched by the producer
+    std::atomic<int> middle{ 1 };     // slot index, plus FRESH once published
+    int frontIndex = 2;               // only touched by the consumer
+};
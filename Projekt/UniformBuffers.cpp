@@ -0,0 +1,25 @@
+#include <glad/glad.h>
+#include "UniformBuffers.h"
+
+int uniformBlockBinding(const std::string& blockName) {
+    if (blockName == "Frame")
+        return FRAME_BLOCK_BINDING;
+    if (blockName == "Lighting")
+        return LIGHTING_BLOCK_BINDING;
+    return -1;
+}
+
+unsigned int createUniformBuffer(unsigned int binding, size_t size, const void* data, bool dynamic) {
+    unsigned int UBO;
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, size, data, dynamic ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+    return UBO;
+}
+
+void updateUniformBuffer(unsigned int UBO, size_t size, const void* data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+}
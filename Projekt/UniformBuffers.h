@@ -0,0 +1,48 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <cstddef>
+
+// std140 uniform blocks shared by all shader programs. Every program that
+// declares one of these blocks gets it bound to the fixed binding point
+// when it is loaded (see Shader::load), so one buffer feeds all of them.
+
+const unsigned int FRAME_BLOCK_BINDING = 0;
+const unsigned int LIGHTING_BLOCK_BINDING = 1;
+
+// Returns the binding point of a known block name, -1 otherwise
+int uniformBlockBinding(const std::string& blockName);
+
+// layout(std140) uniform Frame - rewritten once per frame
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float pad0;
+};
+
+// layout(std140) uniform Lighting - uploaded once at startup
+struct LightingBlock {
+    glm::vec3 lightPosition;
+    float pad0;
+    glm::vec3 lightAmbient;
+    float pad1;
+    glm::vec3 lightDiffuse;
+    float pad2;
+    glm::vec3 lightSpecular;
+    float pad3;
+    glm::vec3 materialSpecular;
+    float materialShininess;
+    glm::vec3 sunColor;
+    float glowRadius;
+};
+
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock must match the std140 layout");
+static_assert(sizeof(LightingBlock) == 96, "LightingBlock must match the std140 layout");
+
+// Creates a uniform buffer and attaches it to the given binding point
+unsigned int createUniformBuffer(unsigned int binding, size_t size, const void* data, bool dynamic);
+
+// Replaces the whole buffer contents. The old storage is orphaned first so
+// the driver never stalls waiting for frames still reading it.
+void updateUniformBuffer(unsigned int UBO, size_t size, const void* data);
@@ -0,0 +1,107 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "VertexFormat.h"
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 31) {
+        // Too large (or inf/NaN): infinity, NaN keeps a mantissa bit
+        bool nan = ((bits >> 23) & 0xFF) == 0xFF && mantissa != 0;
+        return sign | 0x7C00 | (nan ? 0x200 : 0);
+    }
+    if (exponent <= 0) {
+        // Subnormal half or zero
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            ++half;
+        return sign | (uint16_t)half;
+    }
+
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    // Round to nearest even; a carry into the exponent is still correct
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+    return sign | (uint16_t)half;
+}
+
+static int16_t toSnorm16(float value) {
+    return (int16_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+static uint16_t toUnorm16(float value) {
+    return (uint16_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f);
+}
+
+void encodeOctahedral(const float normal[3], int16_t encoded[2]) {
+    float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    // The lower hemisphere is folded over the diagonals
+    if (normal[2] < 0.0f) {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = toSnorm16(x);
+    encoded[1] = toSnorm16(y);
+}
+
+std::vector<PackedVertex> packVertices(const std::vector<float>& vertices) {
+    std::vector<PackedVertex> packed(vertices.size() / 8);
+    for (size_t i = 0; i < packed.size(); ++i) {
+        const float* vertex = &vertices[i * 8];
+        PackedVertex& out = packed[i];
+        for (int k = 0; k < 3; ++k)
+            out.position[k] = floatToHalf(vertex[k]);
+        out.position[3] = floatToHalf(1.0f);
+        encodeOctahedral(vertex + 3, out.normal);
+        out.texCoords[0] = toUnorm16(vertex[6] * 0.5f);
+        out.texCoords[1] = toUnorm16(vertex[7]);
+    }
+    return packed;
+}
+
+int vertexStride(VertexFormat format) {
+    return format == VERTEX_PACKED ? (int)sizeof(PackedVertex) : 8 * (int)sizeof(float);
+}
+
+void setVertexAttributes(VertexFormat format) {
+    if (format == VERTEX_PACKED) {
+        GLsizei stride = sizeof(PackedVertex);
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, texCoords));
+    }
+    else {
+        GLsizei stride = 8 * sizeof(float);
+        // Position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        // Normal attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+        // Texture coord attribute
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+const char* vertexFormatDefines(VertexFormat format) {
+    return format == VERTEX_PACKED ? "#define PACKED_VERTICES\n" : "";
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Vertex layouts of the sphere meshes. Meshes are generated as 8 floats
+// per vertex (32 bytes); the packed layout stores the same data in 16:
+//   position   3 x half float (+ 1 padding half)
+//   normal     octahedral encoding, 2 x snorm16
+//   texCoords  2 x unorm16, u halved so the icosphere seam (u up to ~1.1) fits
+// Shaders reading packed meshes are built with PACKED_VERTICES defined.
+enum VertexFormat {
+    VERTEX_FLOAT,
+    VERTEX_PACKED
+};
+
+struct PackedVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t texCoords[2];
+};
+
+// IEEE 754 binary16, round to nearest
+uint16_t floatToHalf(float value);
+
+// Maps a unit vector onto the octahedron folded into [-1, 1]^2
+void encodeOctahedral(const float normal[3], int16_t encoded[2]);
+
+// Converts interleaved position/normal/texCoords floats to PackedVertex
+std::vector<PackedVertex> packVertices(const std::vector<float>& vertices);
+
+// Bytes per vertex of the format
+int vertexStride(VertexFormat format);
+
+// Sets attributes 0-2 (position, normal, texCoords) of the bound VAO for
+// the buffer bound to GL_ARRAY_BUFFER
+void setVertexAttributes(VertexFormat format);
+
+// Shader defines matching the format, for Shader::load
+const char* vertexFormatDefines(VertexFormat format);
@@ -0,0 +1,67 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+#ifdef PACKED_VERTICES
+// Octahedral-encoded normal, u stored halved (VertexFormat.h)
+layout(location = 1) in vec2 aNormal;
+#else
+layout(location = 1) in vec3 aNormal;
+#endif
+layout(location = 2) in vec2 aTexCoords;
+// Per instance orbital elements (Belt.h): radius, phase, angular speed,
+// scale; inclination and longitude of the ascending node
+layout(location = 3) in vec4 aOrbit;
+layout(location = 4) in vec2 aPlane;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out float Layer;
+flat out float Emissive;
+
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// Simulated seconds since the belt's epoch (Belt.h), the only per-frame
+// input; kept within a few thousand so the float stays exact
+uniform float time;
+uniform float beltLayer;
+
+#ifdef PACKED_VERTICES
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    // Unfold the lower hemisphere
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
+
+void main()
+{
+    // Circular orbit in the xz plane...
+    float angle = aOrbit.y + aOrbit.z * time;
+    vec3 center = aOrbit.x * vec3(cos(angle), 0.0, sin(angle));
+    // ...tilted about x by the inclination, then turned about y to the node
+    float ci = cos(aPlane.x), si = sin(aPlane.x);
+    center = vec3(center.x, center.z * si, center.z * ci);
+    float cn = cos(aPlane.y), sn = sin(aPlane.y);
+    center = vec3(cn * center.x + sn * center.z, center.y, cn * center.z - sn * center.x);
+
+    // Uniform scale and no rotation, so the normal needs no matrix
+    FragPos = center + aPos * aOrbit.w;
+#ifdef PACKED_VERTICES
+    Normal = decodeNormal(aNormal);
+    TexCoords = vec2(aTexCoords.x * 2.0, aTexCoords.y);
+#else
+    Normal = aNormal;
+    TexCoords = aTexCoords;
+#endif
+    Layer = beltLayer;
+    Emissive = 0.0;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
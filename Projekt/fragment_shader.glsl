@@ -1,6 +1,5 @@
 #version 330 core
 struct Material {
-    sampler2D texture_diffuse;
     vec3 specular;
     float shininess;
 };
@@ -19,19 +18,31 @@ in vec2 TexCoords;
 
 out vec4 FragColor;
 
-uniform vec3 viewPos;
-uniform Light light;
-uniform Material material;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+layout(std140) uniform Lighting {
+    Light light;
+    Material material;
+    vec3 sunColor;
+    float glowRadius;
+};
+
+uniform sampler2DArray textures;
+uniform float textureLayer;
 uniform int isSun;
 
 void main()
 {
-    vec3 ambient = light.ambient * texture(material.texture_diffuse, TexCoords).rgb;
+    vec3 ambient = light.ambient * texture(textures, vec3(TexCoords, textureLayer)).rgb;
 
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse, TexCoords).rgb;
+    vec3 diffuse = light.diffuse * diff * texture(textures, vec3(TexCoords, textureLayer)).rgb;
 
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
@@ -41,6 +52,6 @@ void main()
     vec3 result = ambient + diffuse + specular;
     FragColor = vec4(result, 1.0);
     if (isSun == 1) {
-        FragColor = vec4(texture(material.texture_diffuse, TexCoords).rgb, 1.0);
+        FragColor = vec4(texture(textures, vec3(TexCoords, textureLayer)).rgb, 1.0);
     }
 }
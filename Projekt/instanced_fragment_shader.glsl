@@ -0,0 +1,60 @@
+#version 330 core
+struct Material {
+    vec3 specular;
+    float shininess;
+};
+
+struct Light {
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+flat in float Layer;
+flat in float Emissive;
+
+out vec4 FragColor;
+
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+layout(std140) uniform Lighting {
+    Light light;
+    Material material;
+    vec3 sunColor;
+    float glowRadius;
+};
+
+uniform sampler2DArray planetTextures;
+
+void main()
+{
+    vec3 texColor = texture(planetTextures, vec3(TexCoords, Layer)).rgb;
+    if (Emissive > 0.5) {
+        FragColor = vec4(texColor, 1.0);
+        return;
+    }
+
+    vec3 ambient = light.ambient * texColor;
+
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(light.position - FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * texColor;
+
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = light.specular * spec * material.specular;
+
+    vec3 result = ambient + diffuse + specular;
+    FragColor = vec4(result, 1.0);
+}
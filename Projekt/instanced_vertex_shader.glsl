@@ -0,0 +1,53 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+#ifdef PACKED_VERTICES
+// Octahedral-encoded normal, u stored halved (VertexFormat.h)
+layout(location = 1) in vec2 aNormal;
+#else
+layout(location = 1) in vec3 aNormal;
+#endif
+layout(location = 2) in vec2 aTexCoords;
+// Per instance: model matrix (locations 3-6), texture layer + emissive flag,
+// normal matrix (locations 8-10, computed once per body on the CPU)
+layout(location = 3) in mat4 aModel;
+layout(location = 7) in vec2 aLayerEmissive;
+layout(location = 8) in mat3 aNormalMatrix;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out float Layer;
+flat out float Emissive;
+
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+#ifdef PACKED_VERTICES
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    // Unfold the lower hemisphere
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
+
+void main()
+{
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+#ifdef PACKED_VERTICES
+    Normal = aNormalMatrix * decodeNormal(aNormal);
+    TexCoords = vec2(aTexCoords.x * 2.0, aTexCoords.y);
+#else
+    Normal = aNormalMatrix * aNormal;
+    TexCoords = aTexCoords;
+#endif
+    Layer = aLayerEmissive.x;
+    Emissive = aLayerEmissive.y;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}